@@ -0,0 +1,77 @@
+//
+//  barrier_phases.cpp
+//  Benchmarks
+//
+//  Barrier phases per second of CyclicBarrier and CombiningTreeBarrier
+//  (task-2-A): every thread passes the barrier --ops times in a row with no
+//  work in between, which is the synchronization cost of a bulk-synchronous
+//  step. The first argument picks the variant: "combining-tree" (the default)
+//  or "cyclic".
+//
+//  Defaults differ from harness.h: --threads=4,8,16,32,64,128 and 2000 phases
+//  (--ops) after 200 warmup ones. Any option given on the command line wins.
+//
+
+#include "solution.h"
+#include "combining_tree_barrier.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+template <class Barrier, class MakeBarrier, class Pass>
+void RunBarrierBenchmark(const std::string& name, int argc, char** argv, MakeBarrier make_barrier, Pass pass) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (options.header) {
+    std::cout << "benchmark,threads,run,pinned,phases,seconds,phases_per_sec\n";
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::unique_ptr<Barrier> barrier = make_barrier(num_threads);
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          pass(*barrier, thread);
+        }
+      });
+      std::cout << name << "," << num_threads << "," << run << "," << (options.pin ? 1 : 0) << ","
+                << options.ops_per_thread << "," << result.seconds << ","
+                << options.ops_per_thread / result.seconds << "\n";
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "combining-tree";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+
+  std::vector<std::string> defaults = {"--threads=4,8,16,32,64,128", "--ops=2000", "--warmup=200"};
+  std::vector<char*> args = {argv[0]};
+  for (std::string& option: defaults) {
+    args.push_back(&option[0]);
+  }
+  args.insert(args.end(), argv + 1, argv + argc);
+  const int num_args = static_cast<int>(args.size());
+
+  if (variant == "combining-tree") {
+    RunBarrierBenchmark<CombiningTreeBarrier>(
+        "barrier-2-a-combining-tree", num_args, args.data(),
+        [](size_t num_threads) { return std::make_unique<CombiningTreeBarrier>(num_threads); },
+        [](CombiningTreeBarrier& barrier, size_t thread) { barrier.Pass(thread); });
+  } else if (variant == "cyclic") {
+    RunBarrierBenchmark<CyclicBarrier<>>(
+        "barrier-2-a-cyclic", num_args, args.data(),
+        [](size_t num_threads) { return std::make_unique<CyclicBarrier<>>(num_threads); },
+        [](CyclicBarrier<>& barrier, size_t) { barrier.Pass(); });
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
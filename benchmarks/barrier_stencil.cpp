@@ -0,0 +1,110 @@
+//
+//  barrier_stencil.cpp
+//  Benchmarks
+//
+//  Split-phase CyclicBarrier (task-2-A) on a 1D three-point stencil.
+//  Every thread owns --key-range cells and updates them --ops times,
+//  double-buffered. The two edge cells of a chunk are the only ones
+//  the neighbours read, so with split-phase waiting a thread computes its
+//  edges, Arrive()s, computes the interior while the others catch up,
+//  and only then Wait()s; with Pass() it computes everything and then waits.
+//  Each iteration one thread in turn gets twice the interior work, like
+//  a straggler in a real solver: the overlap hides the wait for it.
+//  --cs-work sets the dummy work per cell (default 20).
+//
+//  The first argument picks the variant: "split-phase" (the default)
+//  or "pass". Both print the same checksum of the final grid.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void CellWork(const size_t iterations) {
+  for (size_t j = 0; j < iterations; ++j) {
+    __asm__ __volatile__("" : : : "memory");
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "split-phase";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant != "split-phase" && variant != "pass") {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  const bool split_phase = variant == "split-phase";
+
+  std::vector<std::string> defaults = {"--cs-work=20", "--ops=2000", "--warmup=200"};
+  std::vector<char*> args = {argv[0]};
+  for (std::string& option: defaults) {
+    args.push_back(&option[0]);
+  }
+  args.insert(args.end(), argv + 1, argv + argc);
+  const BenchmarkOptions options = BenchmarkOptions::Parse(static_cast<int>(args.size()), args.data());
+
+  if (options.header) {
+    std::cout << "benchmark,threads,run,cells_per_thread,cell_work,pinned,iterations,seconds,"
+              << "iterations_per_sec,checksum\n";
+  }
+  const size_t chunk = std::max<size_t>(2, options.key_range);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      // Two fixed boundary cells around the grid.
+      const size_t cells = num_threads * chunk + 2;
+      std::vector<double> grids[2] = {std::vector<double>(cells), std::vector<double>(cells)};
+      for (size_t i = 0; i < cells; ++i) {
+        grids[0][i] = grids[1][i] = static_cast<double>(i % 7);
+      }
+      CyclicBarrier<> barrier(num_threads);
+
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        const size_t first = 1 + thread * chunk;
+        const size_t last = first + chunk - 1;
+        auto update = [&](const std::vector<double>& from, std::vector<double>& to, const size_t i,
+                          const size_t work) {
+          to[i] = (from[i - 1] + from[i] + from[i + 1]) / 3;
+          CellWork(work);
+        };
+        for (size_t iteration = begin; iteration < end; ++iteration) {
+          const std::vector<double>& from = grids[iteration % 2];
+          std::vector<double>& to = grids[(iteration + 1) % 2];
+          const size_t interior_work = options.cs_work * (iteration % num_threads == thread ? 2 : 1);
+          update(from, to, first, options.cs_work);
+          update(from, to, last, options.cs_work);
+          if (split_phase) {
+            const auto token = barrier.Arrive();
+            for (size_t i = first + 1; i < last; ++i) {
+              update(from, to, i, interior_work);
+            }
+            barrier.Wait(token);
+          } else {
+            for (size_t i = first + 1; i < last; ++i) {
+              update(from, to, i, interior_work);
+            }
+            barrier.Pass();
+          }
+        }
+      });
+
+      const std::vector<double>& final_grid = grids[(options.warmup_ops + options.ops_per_thread) % 2];
+      double checksum = 0;
+      for (const double cell: final_grid) {
+        checksum += cell;
+      }
+      std::cout << "barrier-2-a-stencil-" << variant << "," << num_threads << "," << run << "," << chunk << ","
+                << options.cs_work << "," << (options.pin ? 1 : 0) << "," << options.ops_per_thread << ","
+                << result.seconds << "," << options.ops_per_thread / result.seconds << "," << checksum << "\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,23 @@
+//
+//  check_known_histories.cpp
+//  Benchmarks
+//
+//  Regression test of the linearizability checker (task-8-A): runs it on
+//  the known histories of every model, without recording anything.
+//  Exits with 1 if any verdict is wrong.
+//
+
+#include "history_check.h"
+
+#include <iostream>
+
+int main() {
+  const bool set = SelfCheck("set", KnownSetHistories(), IsLinearizableSetHistory);
+  const bool queue = SelfCheck("queue", KnownQueueHistories(), IsLinearizableQueueHistory);
+  const bool stack = SelfCheck("stack", KnownStackHistories(), IsLinearizableStackHistory);
+  if (!set || !queue || !stack) {
+    return 1;
+  }
+  std::cout << "known histories: all verdicts right\n";
+  return 0;
+}
@@ -0,0 +1,57 @@
+//
+//  check_queue.cpp
+//  Benchmarks
+//
+//  Linearizability check of LockFreeQueue (task-7-B), or of WaitFreeQueue
+//  if WAIT_FREE_QUEUE is defined.
+//
+
+#include "solution.h"
+#include "wait_free_queue.h"
+
+#include "history_check.h"
+
+#include <memory>
+
+#ifdef WAIT_FREE_QUEUE
+using CheckedQueue = WaitFreeQueue<int64_t>;
+static const char* const kCheckName = "queue-7-b-wait-free";
+#else
+using CheckedQueue = LockFreeQueue<int64_t>;
+static const char* const kCheckName = "queue-7-b";
+#endif
+
+struct RecordQueue {
+  std::unique_ptr<CheckedQueue> queue_;
+  
+  void Reset() {
+    queue_ = std::make_unique<CheckedQueue>();
+  }
+  
+  // Enqueued values are unique: (thread, operation index).
+  void operator()(HistoryRecorder& recorder, const size_t thread, const std::vector<Operation>& operations,
+                  const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (operations[i].kind == 0) {
+        const int64_t value = static_cast<int64_t>(thread) << 32 | i;
+        const HistoryRecorder::Call call = recorder.Invoke(thread, QueueModel::kEnqueue, value);
+        queue_->Enqueue(value);
+        recorder.Respond(call);
+      } else {
+        int64_t value = 0;
+        const HistoryRecorder::Call call = recorder.Invoke(thread, QueueModel::kDequeue);
+        const bool ok = queue_->Dequeue(value);
+        recorder.Respond(call, ok, value);
+      }
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (!SelfCheck(kCheckName, KnownQueueHistories(), IsLinearizableQueueHistory)) {
+    return 2;
+  }
+  return RecordAndCheck(kCheckName, options, {options.push_ratio, 1 - options.push_ratio},
+                        RecordQueue(), IsLinearizableQueueHistory);
+}
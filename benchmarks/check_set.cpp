@@ -0,0 +1,71 @@
+//
+//  check_set.cpp
+//  Benchmarks
+//
+//  Linearizability check of a ConcurrentSet; built once per set task.
+//  SET_NEEDS_ARENA marks the sets that take an ArenaAllocator,
+//  SPLIT_ORDERED_SET checks SplitOrderedHashSet of task-7-C instead.
+//
+
+#include "solution.h"
+#ifdef SPLIT_ORDERED_SET
+#include "split_ordered_set.h"
+#endif
+
+#include "history_check.h"
+
+#include <memory>
+
+#ifdef SPLIT_ORDERED_SET
+template <typename T> using CheckedSet = SplitOrderedHashSet<T>;
+#else
+template <typename T> using CheckedSet = ConcurrentSet<T>;
+#endif
+
+struct RecordSet {
+#ifdef SET_NEEDS_ARENA
+  std::unique_ptr<ArenaAllocator> allocator_;
+#endif
+  std::unique_ptr<CheckedSet<int>> set_;
+  
+  void Reset() {
+#ifdef SET_NEEDS_ARENA
+    set_.reset();
+    allocator_ = std::make_unique<ArenaAllocator>();
+    set_ = std::make_unique<CheckedSet<int>>(*allocator_);
+#else
+    set_ = std::make_unique<CheckedSet<int>>(16);
+#endif
+  }
+  
+  void operator()(HistoryRecorder& recorder, const size_t thread, const std::vector<Operation>& operations,
+                  const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const int key = operations[i].key;
+      bool ok = false;
+      if (operations[i].kind == 0) {
+        const HistoryRecorder::Call call = recorder.Invoke(thread, SetModel::kContains, key);
+        ok = set_->Contains(key);
+        recorder.Respond(call, ok);
+      } else if (operations[i].kind == 1) {
+        const HistoryRecorder::Call call = recorder.Invoke(thread, SetModel::kInsert, key);
+        ok = set_->Insert(key);
+        recorder.Respond(call, ok);
+      } else {
+        const HistoryRecorder::Call call = recorder.Invoke(thread, SetModel::kRemove, key);
+        ok = set_->Remove(key);
+        recorder.Respond(call, ok);
+      }
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (!SelfCheck(CHECK_NAME, KnownSetHistories(), IsLinearizableSetHistory)) {
+    return 2;
+  }
+  const double update = (1 - options.read_ratio) / 2;
+  return RecordAndCheck(CHECK_NAME, options, {options.read_ratio, update, update},
+                        RecordSet(), IsLinearizableSetHistory);
+}
@@ -0,0 +1,47 @@
+//
+//  check_stack.cpp
+//  Benchmarks
+//
+//  Linearizability check of LockFreeStack (task-7-A).
+//
+
+#include "solution.h"
+
+#include "history_check.h"
+
+#include <memory>
+
+struct RecordStack {
+  std::unique_ptr<ConcurrentStack<int64_t>> stack_;
+  
+  void Reset() {
+    stack_ = std::make_unique<ConcurrentStack<int64_t>>();
+  }
+  
+  // Pushed values are unique: (thread, operation index).
+  void operator()(HistoryRecorder& recorder, const size_t thread, const std::vector<Operation>& operations,
+                  const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (operations[i].kind == 0) {
+        const int64_t value = static_cast<int64_t>(thread) << 32 | i;
+        const HistoryRecorder::Call call = recorder.Invoke(thread, StackModel::kPush, value);
+        stack_->Push(value);
+        recorder.Respond(call);
+      } else {
+        int64_t value = 0;
+        const HistoryRecorder::Call call = recorder.Invoke(thread, StackModel::kPop);
+        const bool ok = stack_->Pop(value);
+        recorder.Respond(call, ok, value);
+      }
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (!SelfCheck("stack-7-a", KnownStackHistories(), IsLinearizableStackHistory)) {
+    return 2;
+  }
+  return RecordAndCheck("stack-7-a", options, {options.push_ratio, 1 - options.push_ratio},
+                        RecordStack(), IsLinearizableStackHistory);
+}
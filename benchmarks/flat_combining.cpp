@@ -0,0 +1,101 @@
+//
+//  flat_combining.cpp
+//  Benchmarks
+//
+//  FlatCombining (flat-combining/) over std::deque and std::priority_queue
+//  against the same containers behind a std::mutex, and LockFreeQueue (task-7-B).
+//  The first argument picks the variant:
+//    fc-deque (the default), mutex-deque, fc-priority-queue,
+//    mutex-priority-queue, lock-free-queue
+//
+
+#include "solution.h"
+
+#include "flat_combining.h"
+#include "harness.h"
+
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <queue>
+
+// The obvious alternative: the sequential object behind one mutex,
+// with the same Apply() interface as FlatCombining.
+template <class Seq>
+class MutexWrapped {
+ public:
+  template <class Operation>
+  auto Apply(Operation operation) -> decltype(operation(std::declval<Seq&>())) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return operation(object_);
+  }
+
+ private:
+  std::mutex mutex_;
+  Seq object_;
+};
+
+template <class Wrapped>
+void RunDeque(const std::string& name, int argc, char** argv) {
+  RunContainerBenchmark(name, "queue", argc, argv,
+                        [] { return std::make_unique<Wrapped>(); },
+                        [](Wrapped& queue, const int value) {
+                          queue.Apply([value](std::deque<int>& deque) { deque.push_back(value); });
+                        },
+                        [](Wrapped& queue, int& value) {
+                          return queue.Apply([&value](std::deque<int>& deque) {
+                            if (deque.empty()) {
+                              return false;
+                            }
+                            value = deque.front();
+                            deque.pop_front();
+                            return true;
+                          });
+                        });
+}
+
+template <class Wrapped>
+void RunPriorityQueue(const std::string& name, int argc, char** argv) {
+  RunContainerBenchmark(name, "priority-queue", argc, argv,
+                        [] { return std::make_unique<Wrapped>(); },
+                        [](Wrapped& queue, const int value) {
+                          queue.Apply([value](std::priority_queue<int>& heap) { heap.push(value); });
+                        },
+                        [](Wrapped& queue, int& value) {
+                          return queue.Apply([&value](std::priority_queue<int>& heap) {
+                            if (heap.empty()) {
+                              return false;
+                            }
+                            value = heap.top();
+                            heap.pop();
+                            return true;
+                          });
+                        });
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "fc-deque";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "fc-deque") {
+    RunDeque<FlatCombining<std::deque<int>>>("fc-deque", argc, argv);
+  } else if (variant == "mutex-deque") {
+    RunDeque<MutexWrapped<std::deque<int>>>("mutex-deque", argc, argv);
+  } else if (variant == "fc-priority-queue") {
+    RunPriorityQueue<FlatCombining<std::priority_queue<int>>>("fc-priority-queue", argc, argv);
+  } else if (variant == "mutex-priority-queue") {
+    RunPriorityQueue<MutexWrapped<std::priority_queue<int>>>("mutex-priority-queue", argc, argv);
+  } else if (variant == "lock-free-queue") {
+    RunContainerBenchmark("queue-7-b", "queue", argc, argv,
+                          [] { return std::make_unique<LockFreeQueue<int>>(); },
+                          [](LockFreeQueue<int>& queue, const int value) { queue.Enqueue(value); },
+                          [](LockFreeQueue<int>& queue, int& value) { return queue.Dequeue(value); });
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
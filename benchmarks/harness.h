@@ -0,0 +1,465 @@
+//
+//  harness.h
+//  Benchmarks
+//
+//  Common part of the benchmark executables: command line options, thread
+//  start-up with optional pinning and warmup, hardware counters and CSV output.
+//  Every executable benchmarks one implementation, because the tasks reuse
+//  the same names (ConcurrentSet, StripedHashSet, SpinLock, ...).
+//
+//  Options (all optional):
+//    --threads=1,2,4     thread counts to run, one CSV row per count and run
+//    --ops=N             measured operations per thread
+//    --warmup=N          unmeasured operations per thread before the measurement
+//    --runs=N            repetitions of every configuration
+//    --key-range=N       keys are drawn uniformly from [0, N)
+//    --read-ratio=R      share of lookups in set workloads, the rest is split
+//                        evenly between inserts and removes
+//    --push-ratio=R      share of pushes in queue and stack workloads
+//    --cs-work=N         iterations of dummy work inside a lock's critical section
+//    --pin               pin thread i to CPU i % number of CPUs
+//    --no-header         don't print the CSV header
+//
+//  Thread pool benchmarks run a pool of every --threads count of workers
+//  and take these as well:
+//    --submitters=N      threads submitting tasks to the pool
+//    --elements=N        input size of the parallel algorithms and fork-join
+//    --grain=N           elements per leaf task, 0 for adaptive splitting
+//    --backlog=N         background tasks kept queued under the measured ones
+//    --task-us=N         microseconds of busy work per task
+//    --sleep-us=N        microseconds a blocking task sleeps
+//    --blocking-every=N  every N-th task blocks
+//
+//  Benchmarks that measure more than throughput (latency percentiles,
+//  allocations, ...) append their own columns after the common ones.
+//
+
+#pragma once
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+struct BenchmarkOptions {
+  std::vector<size_t> threads{1, 2, 4};
+  size_t ops_per_thread = 200000;
+  size_t warmup_ops = 20000;
+  size_t runs = 3;
+  size_t key_range = 1024;
+  double read_ratio = 0.8;
+  double push_ratio = 0.5;
+  size_t cs_work = 0;
+  bool pin = false;
+  bool header = true;
+  size_t submitters = 1;
+  size_t elements = 1000000;
+  size_t grain = 0;
+  size_t backlog = 200;
+  size_t task_us = 0;
+  size_t sleep_us = 1000;
+  size_t blocking_every = 4;
+
+  static BenchmarkOptions Parse(int argc, char** argv) {
+    return Parse(argc, argv, BenchmarkOptions());
+  }
+
+  // Starts from the given options, so that a benchmark can have its own defaults.
+  static BenchmarkOptions Parse(int argc, char** argv, BenchmarkOptions options) {
+    for (int i = 1; i < argc; ++i) {
+      const std::string arg = argv[i];
+      const size_t eq = arg.find('=');
+      const std::string name = arg.substr(0, eq);
+      const std::string value = eq == std::string::npos ? "" : arg.substr(eq + 1);
+      if (name == "--threads") {
+        options.threads.clear();
+        size_t begin = 0;
+        while (begin < value.size()) {
+          size_t end = value.find(',', begin);
+          end = end == std::string::npos ? value.size() : end;
+          options.threads.push_back(std::stoul(value.substr(begin, end - begin)));
+          begin = end + 1;
+        }
+      } else if (name == "--ops") {
+        options.ops_per_thread = std::stoul(value);
+      } else if (name == "--warmup") {
+        options.warmup_ops = std::stoul(value);
+      } else if (name == "--runs") {
+        options.runs = std::stoul(value);
+      } else if (name == "--key-range") {
+        options.key_range = std::max<size_t>(1, std::stoul(value));
+      } else if (name == "--read-ratio") {
+        options.read_ratio = std::stod(value);
+      } else if (name == "--push-ratio") {
+        options.push_ratio = std::stod(value);
+      } else if (name == "--cs-work") {
+        options.cs_work = std::stoul(value);
+      } else if (name == "--pin") {
+        options.pin = true;
+      } else if (name == "--no-header") {
+        options.header = false;
+      } else if (name == "--submitters") {
+        options.submitters = std::max<size_t>(1, std::stoul(value));
+      } else if (name == "--elements") {
+        options.elements = std::stoul(value);
+      } else if (name == "--grain") {
+        options.grain = std::stoul(value);
+      } else if (name == "--backlog") {
+        options.backlog = std::stoul(value);
+      } else if (name == "--task-us") {
+        options.task_us = std::stoul(value);
+      } else if (name == "--sleep-us") {
+        options.sleep_us = std::stoul(value);
+      } else if (name == "--blocking-every") {
+        options.blocking_every = std::max<size_t>(1, std::stoul(value));
+      } else {
+        std::cerr << "unknown option " << arg << "\n";
+        std::exit(1);
+      }
+    }
+    return options;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Instructions and last-level cache misses of the calling thread,
+// user space only, through perf_event_open. If the kernel refuses
+// (no PMU, perf_event_paranoid, containers), Valid() is false
+// and the benchmark reports empty columns.
+class PerfCounters {
+ public:
+  PerfCounters() {
+    leader_fd_ = Open(PERF_COUNT_HW_INSTRUCTIONS, -1);
+    if (leader_fd_ >= 0) {
+      cache_misses_fd_ = Open(PERF_COUNT_HW_CACHE_MISSES, leader_fd_);
+    }
+  }
+
+  ~PerfCounters() {
+    if (cache_misses_fd_ >= 0) {
+      close(cache_misses_fd_);
+    }
+    if (leader_fd_ >= 0) {
+      close(leader_fd_);
+    }
+  }
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  bool Valid() const {
+    return leader_fd_ >= 0 && cache_misses_fd_ >= 0;
+  }
+
+  void Start() {
+    if (Valid()) {
+      ioctl(leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  void Stop() {
+    if (Valid()) {
+      ioctl(leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  // Both counters, in the order they were opened.
+  bool Read(uint64_t& instructions, uint64_t& cache_misses) const {
+    struct {
+      uint64_t nr;
+      uint64_t values[2];
+    } group;
+    if (!Valid() || read(leader_fd_, &group, sizeof(group)) != sizeof(group) || group.nr != 2) {
+      return false;
+    }
+    instructions = group.values[0];
+    cache_misses = group.values[1];
+    return true;
+  }
+
+ private:
+  static int Open(const uint64_t config, const int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group_fd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+  }
+
+  int leader_fd_{-1};
+  int cache_misses_fd_{-1};
+};
+
+///////////////////////////////////////////////////////////////////////
+
+struct RunResult {
+  size_t threads = 0;
+  size_t ops = 0;
+  double seconds = 0;
+  bool has_counters = true;
+  uint64_t instructions = 0;
+  uint64_t cache_misses = 0;
+};
+
+// Result of a run that the benchmark timed itself, without hardware counters
+// (e.g. the work ran on the workers of a pool rather than on our threads).
+inline RunResult TimedResult(const size_t threads, const size_t ops, const double seconds) {
+  RunResult result;
+  result.threads = threads;
+  result.ops = ops;
+  result.seconds = seconds;
+  result.has_counters = false;
+  return result;
+}
+
+// Spins (yielding, so that oversubscribed runs still progress) until
+// all participants arrive. Used once per run, so no need to be reusable.
+class StartLine {
+ public:
+  explicit StartLine(const size_t participants) : remaining_(participants) {}
+
+  void ArriveAndWait() {
+    remaining_.fetch_sub(1);
+    while (remaining_.load() != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+ private:
+  std::atomic<size_t> remaining_;
+};
+
+inline void PinCurrentThread(const size_t index) {
+  const size_t num_cpus = std::max(1u, std::thread::hardware_concurrency());
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(index % num_cpus, &cpu_set);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+}
+
+// Runs body(thread_index, begin_op, end_op) on num_threads threads:
+// first over the warmup operations [0, warmup), then, after all threads
+// have finished warming up, over the measured ones [warmup, warmup + ops).
+// The time is from the first measured start to the last finish.
+template <class Body>
+RunResult RunThreads(const BenchmarkOptions& options, const size_t num_threads, Body body) {
+  using Clock = std::chrono::steady_clock;
+  StartLine warmed_up(num_threads);
+  std::vector<Clock::time_point> starts(num_threads);
+  std::vector<Clock::time_point> finishes(num_threads);
+  std::vector<RunResult> per_thread(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&, i] {
+      if (options.pin) {
+        PinCurrentThread(i);
+      }
+      PerfCounters counters;
+      body(i, size_t(0), options.warmup_ops);
+      warmed_up.ArriveAndWait();
+      starts[i] = Clock::now();
+      counters.Start();
+      body(i, options.warmup_ops, options.warmup_ops + options.ops_per_thread);
+      counters.Stop();
+      finishes[i] = Clock::now();
+      per_thread[i].has_counters = counters.Read(per_thread[i].instructions, per_thread[i].cache_misses);
+    });
+  }
+  for (std::thread& thread: threads) {
+    thread.join();
+  }
+  RunResult result;
+  result.threads = num_threads;
+  result.ops = num_threads * options.ops_per_thread;
+  result.seconds = std::chrono::duration<double>(*std::max_element(finishes.begin(), finishes.end()) -
+                                                 *std::min_element(starts.begin(), starts.end())).count();
+  for (const RunResult& thread: per_thread) {
+    result.has_counters = result.has_counters && thread.has_counters;
+    result.instructions += thread.instructions;
+    result.cache_misses += thread.cache_misses;
+  }
+  return result;
+}
+
+// Comma-separated values, for the extra columns of PrintCsvHeader() and PrintCsvRow().
+template <class... Values>
+std::string CsvFields(const Values&... values) {
+  std::ostringstream out;
+  size_t index = 0;
+  ((out << (index++ == 0 ? "" : ",") << values), ...);
+  return out.str();
+}
+
+inline void PrintCsvHeader(const BenchmarkOptions& options, const std::string& extra_columns = "") {
+  if (options.header) {
+    std::cout << "benchmark,workload,threads,run,key_range,read_ratio,push_ratio,cs_work,pinned,"
+              << "ops,seconds,mops_per_sec,instructions_per_op,cache_misses_per_op"
+              << (extra_columns.empty() ? "" : ",") << extra_columns << "\n";
+  }
+}
+
+inline void PrintCsvRow(const std::string& benchmark, const std::string& workload,
+                        const BenchmarkOptions& options, const size_t run, const RunResult& result,
+                        const std::string& extra_values = "") {
+  std::cout << benchmark << "," << workload << "," << result.threads << "," << run << ","
+            << options.key_range << "," << options.read_ratio << "," << options.push_ratio << ","
+            << options.cs_work << "," << (options.pin ? 1 : 0) << ","
+            << result.ops << "," << result.seconds << "," << result.ops / result.seconds / 1e6 << ",";
+  if (result.has_counters) {
+    std::cout << static_cast<double>(result.instructions) / result.ops << ","
+              << static_cast<double>(result.cache_misses) / result.ops;
+  } else {
+    std::cout << ",";
+  }
+  std::cout << (extra_values.empty() ? "" : ",") << extra_values << "\n";
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Operations are drawn before the run, so the random generator stays out of the measurement.
+struct Operation {
+  uint8_t kind;
+  int key;
+};
+
+inline std::vector<Operation> DrawOperations(const size_t count, const size_t key_range,
+                                             const std::vector<double>& kind_weights, const unsigned seed) {
+  std::mt19937 generator(seed);
+  std::discrete_distribution<int> kinds(kind_weights.begin(), kind_weights.end());
+  std::uniform_int_distribution<int> keys(0, static_cast<int>(key_range) - 1);
+  std::vector<Operation> operations(count);
+  for (Operation& operation: operations) {
+    operation.kind = static_cast<uint8_t>(kinds(generator));
+    operation.key = keys(generator);
+  }
+  return operations;
+}
+
+// Set workload: Contains with probability read_ratio, Insert or Remove otherwise.
+// Every run gets a fresh set from make_set(), filled with half of the key range.
+template <class MakeSet>
+void RunSetBenchmark(const std::string& name, int argc, char** argv, MakeSet make_set) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  const double update = (1 - options.read_ratio) / 2;
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::vector<std::vector<Operation>> operations;
+      for (size_t i = 0; i < num_threads; ++i) {
+        operations.push_back(DrawOperations(options.warmup_ops + options.ops_per_thread, options.key_range,
+                                            {options.read_ratio, update, update}, run * 1000 + i + 1));
+      }
+      auto set = make_set();
+      for (size_t key = 0; key < options.key_range; key += 2) {
+        set->Insert(static_cast<int>(key));
+      }
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const Operation& operation = operations[thread][i];
+          if (operation.kind == 0) {
+            set->Contains(operation.key);
+          } else if (operation.kind == 1) {
+            set->Insert(operation.key);
+          } else {
+            set->Remove(operation.key);
+          }
+        }
+      });
+      PrintCsvRow(name, "set", options, run, result);
+    }
+  }
+}
+
+// Queue and stack workload: push with probability push_ratio, pop otherwise
+// (a pop of an empty container counts as an operation too).
+// The container starts with key_range elements.
+template <class MakeContainer, class Push, class Pop>
+void RunContainerBenchmark(const std::string& name, const std::string& workload, int argc, char** argv,
+                           MakeContainer make_container, Push push, Pop pop) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::vector<std::vector<Operation>> operations;
+      for (size_t i = 0; i < num_threads; ++i) {
+        operations.push_back(DrawOperations(options.warmup_ops + options.ops_per_thread, options.key_range,
+                                            {options.push_ratio, 1 - options.push_ratio}, run * 1000 + i + 1));
+      }
+      auto container = make_container();
+      for (size_t i = 0; i < options.key_range; ++i) {
+        push(*container, static_cast<int>(i));
+      }
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        int value = 0;
+        for (size_t i = begin; i < end; ++i) {
+          const Operation& operation = operations[thread][i];
+          if (operation.kind == 0) {
+            push(*container, operation.key);
+          } else {
+            pop(*container, value);
+          }
+        }
+      });
+      PrintCsvRow(name, workload, options, run, result);
+    }
+  }
+}
+
+// Lock workload: every operation acquires the lock, increments a shared counter
+// and spins cs_work iterations inside the critical section.
+// critical_section(lock, thread_index, work) must run work() under the lock.
+template <class MakeLock, class CriticalSection>
+void RunLockBenchmark(const std::string& name, int argc, char** argv,
+                      MakeLock make_lock, CriticalSection critical_section) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      auto lock = make_lock(num_threads);
+      size_t counter = 0;
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          critical_section(*lock, thread, [&] {
+            ++counter;
+            for (size_t j = 0; j < options.cs_work; ++j) {
+              __asm__ __volatile__("" : : : "memory");
+            }
+          });
+        }
+      });
+      if (counter != num_threads * (options.warmup_ops + options.ops_per_thread)) {
+        std::cerr << name << ": mutual exclusion violated\n";
+        std::exit(1);
+      }
+      PrintCsvRow(name, "lock", options, run, result);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
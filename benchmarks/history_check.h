@@ -0,0 +1,63 @@
+//
+//  history_check.h
+//  Benchmarks
+//
+//  Records histories of a structure under the benchmark workloads
+//  and checks them for linearizability (task-8-A). Accepts the options
+//  of harness.h except --warmup: every operation must be in the history.
+//
+
+#pragma once
+
+#include "harness.h"
+#include "known_histories.h"
+#include "linearizability_checker.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Makes sure the checker still gives the right verdicts on the known histories.
+template <class Check>
+bool SelfCheck(const std::string& name, const std::vector<KnownHistory>& known, Check check) {
+  const std::vector<std::string> wrong = WrongVerdicts(known, check);
+  for (const std::string& history: wrong) {
+    std::cerr << name << ": wrong verdict on known history \"" << history << "\"\n";
+  }
+  return wrong.empty();
+}
+
+// record(recorder, thread, operations of the thread) runs and records one thread's share
+// of the workload, check(history) decides whether the history is linearizable.
+// Returns the exit code.
+template <class Record, class Check>
+int RecordAndCheck(const std::string& name, const BenchmarkOptions& parsed_options,
+                   const std::vector<double>& kind_weights, Record record, Check check) {
+  BenchmarkOptions options = parsed_options;
+  options.warmup_ops = 0;
+  bool all_linearizable = true;
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::vector<std::vector<Operation>> operations;
+      for (size_t i = 0; i < num_threads; ++i) {
+        operations.push_back(DrawOperations(options.ops_per_thread, options.key_range,
+                                            kind_weights, run * 1000 + i + 1));
+      }
+      HistoryRecorder recorder(num_threads, options.ops_per_thread);
+      record.Reset();
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        record(recorder, thread, operations[thread], begin, end);
+      });
+      const History history = recorder.Collect();
+      const auto start = std::chrono::steady_clock::now();
+      const bool linearizable = check(history);
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      std::cout << name << ": " << num_threads << " threads, " << history.size() << " operations recorded in "
+                << result.seconds << " s, checked in " << elapsed.count() << " s: "
+                << (linearizable ? "linearizable" : "NOT LINEARIZABLE") << "\n";
+      all_linearizable = all_linearizable && linearizable;
+    }
+  }
+  return all_linearizable ? 0 : 1;
+}
@@ -0,0 +1,129 @@
+//
+//  lock_cohort.cpp
+//  Benchmarks
+//
+//  Throughput and fairness of CohortLock against MCSSpinLock (task-5-A).
+//  All threads share a budget of threads x --ops acquisitions and stop when
+//  it runs out, so a lock that favours some threads shows up as uneven
+//  per-thread counts. Every critical section also notes whether the owner
+//  is on another NUMA node than the previous one: node switches per
+//  acquisition is what the cohort lock cuts down.
+//
+//  The first argument picks the variant: "cohort" (the default, nodes from
+//  sysfs), "cohort-simulated" (CPUs split into two simulated nodes, to try
+//  it out on a single-socket machine) or "mcs". Use --pin, otherwise threads
+//  move between nodes. --warmup is ignored.
+//
+//  Output: CSV with throughput, node switches per acquisition, and
+//  the smallest and largest per-thread share of the acquisitions relative
+//  to a fair share (1 is perfectly fair).
+//
+
+#include "solution.h"
+#include "cohort_lock.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+template <class MakeLock, class CriticalSection>
+void RunCohortBenchmark(const std::string& name, int argc, char** argv, const NumaTopology& topology,
+                        MakeLock make_lock, CriticalSection critical_section) {
+  using Clock = std::chrono::steady_clock;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (options.header) {
+    std::cout << "benchmark,threads,run,nodes,cs_work,pinned,ops,mops_per_sec,"
+              << "node_switches_per_op,min_fair_share,max_fair_share\n";
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      auto lock = make_lock();
+      const size_t budget = num_threads * options.ops_per_thread;
+      // Touched under the lock only.
+      size_t acquisitions = 0;
+      size_t node_switches = 0;
+      size_t last_node = 0;
+      std::vector<size_t> counts(num_threads);
+      StartLine start_line(num_threads);
+      std::vector<std::thread> threads;
+      const Clock::time_point start = Clock::now();
+      for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i] {
+          if (options.pin) {
+            PinCurrentThread(i);
+          }
+          start_line.ArriveAndWait();
+          size_t mine = 0;
+          bool done = false;
+          while (!done) {
+            const size_t node = topology.CurrentNode();
+            critical_section(*lock, [&] {
+              if (acquisitions == budget) {
+                done = true;
+                return;
+              }
+              ++acquisitions;
+              ++mine;
+              node_switches += node != last_node ? 1 : 0;
+              last_node = node;
+              for (size_t j = 0; j < options.cs_work; ++j) {
+                __asm__ __volatile__("" : : : "memory");
+              }
+            });
+          }
+          counts[i] = mine;
+        });
+      }
+      for (std::thread& thread: threads) {
+        thread.join();
+      }
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      const double fair = static_cast<double>(budget) / num_threads;
+      std::cout << name << "," << num_threads << "," << run << "," << topology.NumNodes() << ","
+                << options.cs_work << "," << (options.pin ? 1 : 0) << "," << budget << ","
+                << budget / seconds / 1e6 << "," << static_cast<double>(node_switches) / budget << ","
+                << *std::min_element(counts.begin(), counts.end()) / fair << ","
+                << *std::max_element(counts.begin(), counts.end()) / fair << "\n";
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "cohort";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  auto cohort_section = [](CohortLock& lock, auto work) {
+    CohortLock::Guard guard(lock);
+    work();
+  };
+  if (variant == "cohort") {
+    const NumaTopology topology = NumaTopology::Discover();
+    RunCohortBenchmark("lock-5-a-cohort", argc, argv, topology,
+                       [&topology] { return std::make_unique<CohortLock>(topology); }, cohort_section);
+  } else if (variant == "cohort-simulated") {
+    const NumaTopology topology = NumaTopology::Simulate(2);
+    RunCohortBenchmark("lock-5-a-cohort-simulated", argc, argv, topology,
+                       [&topology] { return std::make_unique<CohortLock>(topology); }, cohort_section);
+  } else if (variant == "mcs") {
+    RunCohortBenchmark("lock-5-a", argc, argv, NumaTopology::Discover(),
+                       [] { return std::make_unique<MCSSpinLock<>>(); },
+                       [](MCSSpinLock<>& spinlock, auto work) {
+                         MCSSpinLock<>::Guard guard(spinlock);
+                         work();
+                       });
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
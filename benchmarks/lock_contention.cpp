@@ -0,0 +1,99 @@
+//
+//  lock_contention.cpp
+//  Benchmarks
+//
+//  Skewed-key workload on StripedHashSet with profiled stripes.
+//  Keys follow a Zipf distribution, so the stripes of the few most
+//  frequent keys take most of the traffic and rise to the top of
+//  the contention report.
+//
+//  Usage: lock_contention [threads] [ops per thread] [stripes] [key range] [zipf exponent]
+//
+
+#include "../task-4-A/solution.h"
+#include "../profiler/contention_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using ProfiledSet = StripedHashSet<int, std::hash<int>, ProfiledLock<std::mutex>>;
+
+// Cumulative distribution of Zipf(exponent) over [0, key_range).
+static std::vector<double> ZipfDistribution(const size_t key_range, const double exponent) {
+  std::vector<double> cdf(key_range);
+  double sum = 0;
+  for (size_t i = 0; i < key_range; ++i) {
+    sum += 1.0 / std::pow(i + 1, exponent);
+    cdf[i] = sum;
+  }
+  for (double& value: cdf) {
+    value /= sum;
+  }
+  return cdf;
+}
+
+// Keys are drawn up front so that the random generator stays out of the measurement.
+static std::vector<int> DrawKeys(const std::vector<double>& cdf, const size_t count, const unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::vector<int> keys(count);
+  for (int& key: keys) {
+    key = static_cast<int>(std::lower_bound(cdf.begin(), cdf.end(), uniform(generator)) - cdf.begin());
+  }
+  return keys;
+}
+
+int main(int argc, char** argv) {
+  const size_t num_threads = argc > 1 ? std::atoi(argv[1]) : 4;
+  const size_t ops_per_thread = argc > 2 ? std::atoi(argv[2]) : 200000;
+  const size_t num_stripes = argc > 3 ? std::atoi(argv[3]) : 16;
+  const size_t key_range = argc > 4 ? std::atoi(argv[4]) : 100000;
+  const double exponent = argc > 5 ? std::atof(argv[5]) : 1.1;
+
+  std::unique_ptr<ProfiledSet> set;
+  {
+    ContentionProfiler::NamingScope naming("stripe");
+    set = std::make_unique<ProfiledSet>(num_stripes);
+  }
+
+  const std::vector<double> cdf = ZipfDistribution(key_range, exponent);
+  std::vector<std::vector<int>> keys;
+  for (size_t i = 0; i < num_threads; ++i) {
+    keys.push_back(DrawKeys(cdf, ops_per_thread, i + 1));
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&set, &keys, i] {
+      // 20% inserts, 10% removes, 70% lookups.
+      size_t op = 0;
+      for (const int key: keys[i]) {
+        const size_t kind = op++ % 10;
+        if (kind < 2) {
+          set->Insert(key);
+        } else if (kind < 3) {
+          set->Remove(key);
+        } else {
+          set->Contains(key);
+        }
+      }
+    });
+  }
+  for (std::thread& thread: threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout << num_threads * ops_per_thread / elapsed.count() << " ops/s, "
+            << "zipf exponent " << exponent << ", " << num_stripes << " stripes\n\n";
+  ContentionProfiler::Instance().PrintReport(std::cout);
+  return 0;
+}
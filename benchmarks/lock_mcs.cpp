@@ -0,0 +1,20 @@
+//
+//  lock_mcs.cpp
+//  Benchmarks
+//
+//  MCSSpinLock (task-5-A).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunLockBenchmark("lock-5-a", argc, argv,
+                   [](size_t) { return std::make_unique<MCSSpinLock<>>(); },
+                   [](MCSSpinLock<>& spinlock, size_t, auto work) {
+                     MCSSpinLock<>::Guard guard(spinlock);
+                     work();
+                   });
+  return 0;
+}
@@ -0,0 +1,71 @@
+//
+//  lock_oversubscribed.cpp
+//  Benchmarks
+//
+//  MCSMutex against MCSSpinLock (task-5-A) and std::mutex with twice as many
+//  threads as CPUs. A spinning waiter burns its whole time slice while
+//  the thread it waits for is descheduled; a parked one gives the CPU away.
+//  The first argument picks the variant: "mcs-mutex" (the default),
+//  "mcs-spin" or "std-mutex".
+//
+//  Defaults differ from harness.h: --threads is 2 x the number of CPUs,
+//  --cs-work=100, and fewer operations, since the spin-only lock may hand
+//  over only once per time slice. Any option given on the command line wins.
+//
+
+#include "solution.h"
+#include "mcs_mutex.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+  std::string variant = "mcs-mutex";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+
+  const size_t num_cpus = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::string> defaults = {"--threads=" + std::to_string(2 * num_cpus), "--cs-work=100",
+                                       "--ops=5000", "--warmup=500"};
+  std::vector<char*> args = {argv[0]};
+  for (std::string& option: defaults) {
+    args.push_back(&option[0]);
+  }
+  args.insert(args.end(), argv + 1, argv + argc);
+  const int num_args = static_cast<int>(args.size());
+
+  if (variant == "mcs-mutex") {
+    RunLockBenchmark("lock-5-a-mcs-mutex", num_args, args.data(),
+                     [](size_t) { return std::make_unique<MCSMutex>(); },
+                     [](MCSMutex& mutex, size_t, auto work) {
+                       MCSMutex::Guard guard(mutex);
+                       work();
+                     });
+  } else if (variant == "mcs-spin") {
+    RunLockBenchmark("lock-5-a-mcs-spin", num_args, args.data(),
+                     [](size_t) { return std::make_unique<MCSSpinLock<>>(); },
+                     [](MCSSpinLock<>& spinlock, size_t, auto work) {
+                       MCSSpinLock<>::Guard guard(spinlock);
+                       work();
+                     });
+  } else if (variant == "std-mutex") {
+    RunLockBenchmark("lock-std-mutex", num_args, args.data(),
+                     [](size_t) { return std::make_unique<std::mutex>(); },
+                     [](std::mutex& mutex, size_t, auto work) {
+                       std::lock_guard<std::mutex> guard(mutex);
+                       work();
+                     });
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
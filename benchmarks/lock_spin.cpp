@@ -0,0 +1,21 @@
+//
+//  lock_spin.cpp
+//  Benchmarks
+//
+//  Test-and-set SpinLock of the optimistic list (task-4-B).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunLockBenchmark("lock-4-b", argc, argv,
+                   [](size_t) { return std::make_unique<SpinLock>(); },
+                   [](SpinLock& spinlock, size_t, auto work) {
+                     spinlock.Lock();
+                     work();
+                     spinlock.Unlock();
+                   });
+  return 0;
+}
@@ -0,0 +1,93 @@
+//
+//  lock_timeout_latency.cpp
+//  Benchmarks
+//
+//  Acquisition latency of TimeoutMCSLock (task-5-A) under the lock workload
+//  of harness.h. The first argument is the timeout of TryAcquireFor()
+//  in microseconds (default 50), or "blocking" for the unconditional
+//  Acquire(). A timed-out attempt is measured too: the time until it gives
+//  up is what a request handler waits before it can drop the request.
+//
+//  Output: CSV with the share of successful attempts and nanosecond
+//  percentiles over all measured attempts.
+//
+
+#include "timeout_mcs_lock.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+  using Clock = std::chrono::steady_clock;
+  std::string variant = "50";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  const bool blocking = variant == "blocking";
+  const std::chrono::microseconds timeout(blocking ? 0 : std::stoul(variant));
+
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (options.header) {
+    std::cout << "benchmark,threads,run,timeout_us,cs_work,pinned,attempts,success_ratio,"
+              << "p50_ns,p99_ns,p99_9_ns,max_ns\n";
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      TimeoutMCSLock lock;
+      std::vector<std::vector<uint64_t>> latencies(num_threads);
+      std::vector<size_t> successes(num_threads);
+      for (std::vector<uint64_t>& thread: latencies) {
+        thread.reserve(options.ops_per_thread);
+      }
+      RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        const bool measured = begin >= options.warmup_ops;
+        for (size_t i = begin; i < end; ++i) {
+          const Clock::time_point start = Clock::now();
+          bool ok = true;
+          if (blocking) {
+            lock.Acquire();
+          } else {
+            ok = lock.TryAcquireFor(timeout);
+          }
+          const Clock::time_point acquired = Clock::now();
+          if (ok) {
+            for (size_t j = 0; j < options.cs_work; ++j) {
+              __asm__ __volatile__("" : : : "memory");
+            }
+            lock.Release();
+          }
+          if (measured) {
+            latencies[thread].push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(acquired - start).count());
+            successes[thread] += ok ? 1 : 0;
+          }
+        }
+      });
+      std::vector<uint64_t> all;
+      size_t total_successes = 0;
+      for (size_t i = 0; i < num_threads; ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        total_successes += successes[i];
+      }
+      std::sort(all.begin(), all.end());
+      auto percentile = [&all](const double fraction) {
+        return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(fraction * all.size()))];
+      };
+      std::cout << "lock-5-a-timeout-mcs," << num_threads << "," << run << ","
+                << (blocking ? std::string("blocking") : std::to_string(timeout.count())) << ","
+                << options.cs_work << "," << (options.pin ? 1 : 0) << "," << all.size() << ","
+                << static_cast<double>(total_successes) / std::max<size_t>(1, all.size()) << ","
+                << percentile(0.5) << "," << percentile(0.99) << "," << percentile(0.999) << ","
+                << (all.empty() ? 0 : all.back()) << "\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,103 @@
+//
+//  lock_tree_latency.cpp
+//  Benchmarks
+//
+//  Latency of a lock/unlock pair of TreeMutex and FastPathTreeMutex (task-1-E)
+//  under the lock workload of harness.h: uncontended with one thread, fully
+//  contended with more (every thread locks again right after unlocking).
+//  Every pair is timed from the call of lock() until unlock() returns.
+//
+//  The first argument picks the mutex: "tree" or "fast-path"; without it
+//  both run.
+//
+//  Output: the CSV of harness.h with nanosecond statistics of the pairs.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+template <class Mutex>
+void RunLatency(const std::string& name, const BenchmarkOptions& options) {
+  using Clock = std::chrono::steady_clock;
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      Mutex mutex(num_threads);
+      size_t counter = 0;
+      std::vector<std::vector<uint64_t>> latencies(num_threads);
+      for (std::vector<uint64_t>& thread: latencies) {
+        thread.reserve(options.ops_per_thread);
+      }
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        const bool measured = begin >= options.warmup_ops;
+        for (size_t i = begin; i < end; ++i) {
+          const Clock::time_point start = Clock::now();
+          mutex.lock(thread);
+          ++counter;
+          for (size_t j = 0; j < options.cs_work; ++j) {
+            __asm__ __volatile__("" : : : "memory");
+          }
+          mutex.unlock(thread);
+          if (measured) {
+            latencies[thread].push_back(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+          }
+        }
+      });
+      if (counter != num_threads * (options.warmup_ops + options.ops_per_thread)) {
+        std::cerr << name << ": mutual exclusion violated\n";
+        std::exit(1);
+      }
+      std::vector<uint64_t> all;
+      uint64_t sum = 0;
+      for (const std::vector<uint64_t>& thread: latencies) {
+        all.insert(all.end(), thread.begin(), thread.end());
+        for (const uint64_t latency: thread) {
+          sum += latency;
+        }
+      }
+      std::sort(all.begin(), all.end());
+      auto percentile = [&all](const double fraction) {
+        return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(fraction * all.size()))];
+      };
+      PrintCsvRow(name, "lock", options, run, result,
+                  CsvFields(all.empty() ? 0 : sum / all.size(), percentile(0.5), percentile(0.99),
+                            percentile(0.999), all.empty() ? 0 : all.back()));
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> variants = {"tree", "fast-path"};
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    if (std::find(variants.begin(), variants.end(), argv[1]) == variants.end()) {
+      std::cerr << "unknown variant " << argv[1] << "\n";
+      return 1;
+    }
+    variants = {argv[1]};
+    --argc;
+    ++argv;
+  }
+  BenchmarkOptions defaults;
+  defaults.threads = {1, 2, 4, 8, 16, 32, 64};
+  defaults.ops_per_thread = 20000;
+  defaults.warmup_ops = 2000;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+
+  PrintCsvHeader(options, "mean_ns,p50_ns,p99_ns,p99_9_ns,max_ns");
+  for (const std::string& variant: variants) {
+    if (variant == "tree") {
+      RunLatency<TreeMutex>("lock-1-e-latency", options);
+    } else {
+      RunLatency<FastPathTreeMutex>("lock-1-e-fast-path-latency", options);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,35 @@
+//
+//  lock_tree_mutex.cpp
+//  Benchmarks
+//
+//  TreeMutex and FastPathTreeMutex (task-1-E).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <cstring>
+
+int main(int argc, char** argv) {
+  // The first argument may pick the variant: "fast-path" or "tree" (the default).
+  if (argc > 1 && std::strcmp(argv[1], "fast-path") == 0) {
+    RunLockBenchmark("lock-1-e-fast-path", argc - 1, argv + 1,
+                     [](const size_t num_threads) { return std::make_unique<FastPathTreeMutex>(num_threads); },
+                     [](FastPathTreeMutex& mutex, const size_t thread, auto work) {
+                       mutex.lock(thread);
+                       work();
+                       mutex.unlock(thread);
+                     });
+    return 0;
+  }
+  const int skip = argc > 1 && std::strcmp(argv[1], "tree") == 0 ? 1 : 0;
+  RunLockBenchmark("lock-1-e", argc - skip, argv + skip,
+                   [](const size_t num_threads) { return std::make_unique<TreeMutex>(num_threads); },
+                   [](TreeMutex& mutex, const size_t thread, auto work) {
+                     mutex.lock(thread);
+                     work();
+                     mutex.unlock(thread);
+                   });
+  return 0;
+}
@@ -0,0 +1,66 @@
+//
+//  marked_pointer_cas.cpp
+//  Benchmarks
+//
+//  CAS throughput of TaggedAtomicMarkedPointer and VersionedAtomicMarkedPointer
+//  (task-7-C). Every operation loads the shared pointer and tries to move it
+//  to the next of --key-range nodes with the mark flipped, the way
+//  LockFreeLinkedSet links and marks its nodes; a failed CAS counts as
+//  an operation too. The first argument picks the variant: "tagged"
+//  (the default) or "versioned".
+//
+
+#include "atomic_marked_pointer.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Node {
+  size_t next_;
+};
+
+template <template <typename U> class MarkedAtomic>
+void RunCasBenchmark(const std::string& name, int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  std::vector<Node> nodes(options.key_range);
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].next_ = (i + 1) % nodes.size();
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      MarkedAtomic<Node> pointer(&nodes[0], false);
+      const RunResult result = RunThreads(options, num_threads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const typename MarkedAtomic<Node>::MarkedPointer current = pointer.Load();
+          typename MarkedAtomic<Node>::MarkedPointer desired = current;
+          desired.ptr_ = &nodes[current.ptr_->next_];
+          desired.marked_ = !current.marked_;
+          pointer.CompareAndSet(current, desired);
+        }
+      });
+      PrintCsvRow(name, "cas", options, run, result);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "tagged";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "tagged") {
+    RunCasBenchmark<TaggedAtomicMarkedPointer>("marked-pointer-tagged", argc, argv);
+  } else if (variant == "versioned") {
+    RunCasBenchmark<VersionedAtomicMarkedPointer>("marked-pointer-versioned", argc, argv);
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
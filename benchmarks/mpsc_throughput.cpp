@@ -0,0 +1,139 @@
+//
+//  mpsc_throughput.cpp
+//  Benchmarks
+//
+//  Many producers, one consumer: IntrusiveMpscQueue and LockFreeQueue (task-7-B)
+//  and BlockingQueue (task-3-A). --threads counts the producers; every one
+//  of them sends --ops messages and the consumer receives all of them, so
+//  the "threads" column is the number of producers and mops_per_sec is
+//  messages received per second. The first argument picks the variant:
+//  "intrusive" (the default), "lock-free" or "blocking".
+//
+
+#include "../task-3-A/solution.h"
+#include "../task-7-B/solution.h"
+#include "../task-7-B/mpsc_queue.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Message : MpscHook<> {
+  int value;
+};
+
+// Intrusive messages are preallocated and pushed once each,
+// so the measured loop allocates nothing.
+struct IntrusiveChannel {
+  IntrusiveMpscQueue<Message> queue_;
+  std::vector<std::vector<Message>> messages_;
+
+  IntrusiveChannel(const size_t num_producers, const size_t messages_per_producer)
+      : messages_(num_producers, std::vector<Message>(messages_per_producer)) {}
+
+  void Send(const size_t producer, const size_t index) {
+    Message& message = messages_[producer][index];
+    message.value = static_cast<int>(index);
+    queue_.Push(&message);
+  }
+
+  int Receive() {
+    while (true) {
+      if (Message* message = queue_.Pop()) {
+        return message->value;
+      }
+      std::this_thread::yield();
+    }
+  }
+};
+
+struct LockFreeChannel {
+  LockFreeQueue<int> queue_;
+
+  LockFreeChannel(size_t, size_t) {}
+
+  void Send(size_t, const size_t index) {
+    queue_.Enqueue(static_cast<int>(index));
+  }
+
+  int Receive() {
+    int value = 0;
+    while (!queue_.Dequeue(value)) {
+      std::this_thread::yield();
+    }
+    return value;
+  }
+};
+
+struct BlockingChannel {
+  BlockingQueue<int> queue_;
+
+  BlockingChannel(const size_t num_producers, size_t) : queue_(1024 * num_producers) {}
+
+  void Send(size_t, const size_t index) {
+    queue_.Put(static_cast<int>(index));
+  }
+
+  int Receive() {
+    int value = 0;
+    queue_.Get(value);
+    return value;
+  }
+};
+
+// Thread 0 is the consumer, threads 1..producers are the producers.
+template <class Channel>
+void RunMpsc(const std::string& name, int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  const size_t messages_per_producer = options.warmup_ops + options.ops_per_thread;
+  for (const size_t num_producers: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      auto channel = std::make_unique<Channel>(num_producers, messages_per_producer);
+      int64_t checksum = 0;
+      RunResult result = RunThreads(options, num_producers + 1, [&](size_t thread, size_t begin, size_t end) {
+        if (thread == 0) {
+          for (size_t i = begin * num_producers; i < end * num_producers; ++i) {
+            checksum += channel->Receive();
+          }
+        } else {
+          for (size_t i = begin; i < end; ++i) {
+            channel->Send(thread - 1, i);
+          }
+        }
+      });
+      const int64_t per_producer = static_cast<int64_t>(messages_per_producer) * (messages_per_producer - 1) / 2;
+      if (checksum != per_producer * static_cast<int64_t>(num_producers)) {
+        std::cerr << name << ": lost or duplicated messages\n";
+        std::exit(1);
+      }
+      result.threads = num_producers;
+      result.ops = num_producers * options.ops_per_thread;
+      PrintCsvRow(name, "mpsc", options, run, result);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "intrusive";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "intrusive") {
+    RunMpsc<IntrusiveChannel>("mpsc-7-b-intrusive", argc, argv);
+  } else if (variant == "lock-free") {
+    RunMpsc<LockFreeChannel>("queue-7-b", argc, argv);
+  } else if (variant == "blocking") {
+    RunMpsc<BlockingChannel>("queue-3-a", argc, argv);
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
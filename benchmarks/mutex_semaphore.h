@@ -0,0 +1,37 @@
+//
+//  mutex_semaphore.h
+//  Benchmarks
+//
+//  The semaphore task-2-B-semaphore and task-2-B-centipede had before
+//  the futex Semaphore and TokenRing, kept as the baseline to compare with.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+class MutexSemaphore {
+ public:
+  MutexSemaphore(const size_t start = 0) : signals_counter_(start) {}
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (signals_counter_ == 0) {
+      get_signal_cv_.wait(lock, [this](){ return signals_counter_ > 0; });
+    }
+    --signals_counter_;
+  }
+
+  void Signal() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    ++signals_counter_;
+    get_signal_cv_.notify_one();
+  }
+
+ private:
+  size_t signals_counter_;
+  std::condition_variable get_signal_cv_;
+  std::mutex mtx_;
+};
@@ -0,0 +1,133 @@
+//
+//  parallel_algorithms.cpp
+//  Benchmarks
+//
+//  ParallelFor, ParallelReduce, ParallelTransform and ParallelSort of task-3-B
+//  against the sequential std:: algorithms on the same input of --elements
+//  elements, for a pool of every --threads count of workers. --grain = 0
+//  (the default) splits adaptively. Every run times both; speedup is
+//  std_seconds / seconds, and the results are checked against std::.
+//
+//  The first argument picks the algorithm: "for", "reduce", "transform"
+//  or "sort"; without it all four run.
+//
+//  Output: the CSV of harness.h, one operation per element; threads is
+//  the number of workers.
+//
+
+#include "parallel_algorithms.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Seconds of run(), with prepare() before it outside of the measurement.
+template <class Prepare, class Run>
+static double Seconds(Prepare prepare, Run run) {
+  prepare();
+  const Clock::time_point start = Clock::now();
+  run();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static uint64_t Mix(uint64_t x) {
+  return x * 2654435761u + 1;
+}
+
+int main(int argc, char** argv) {
+  std::vector<std::string> algorithms = {"for", "reduce", "transform", "sort"};
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    if (std::find(algorithms.begin(), algorithms.end(), argv[1]) == algorithms.end()) {
+      std::cerr << "unknown algorithm " << argv[1] << "\n";
+      return 1;
+    }
+    algorithms = {argv[1]};
+    --argc;
+    ++argv;
+  }
+  BenchmarkOptions defaults;
+  defaults.elements = 10000000;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  const size_t num_elements = options.elements;
+  const size_t grain = options.grain;
+
+  std::vector<uint64_t> input(num_elements);
+  std::mt19937_64 random(42);
+  for (uint64_t& value: input) {
+    value = random();
+  }
+  std::vector<uint64_t> data;
+  std::vector<uint64_t> output(num_elements);
+  std::vector<uint64_t> expected_output(num_elements);
+  std::transform(input.begin(), input.end(), expected_output.begin(), Mix);
+  std::vector<uint64_t> sorted = input;
+  std::sort(sorted.begin(), sorted.end());
+  const uint64_t expected_sum = std::accumulate(input.begin(), input.end(), uint64_t(0));
+  // Keeps the sequential reduction from being optimized away.
+  volatile uint64_t sink = 0;
+  auto reset = [&] { data = input; };
+  auto nothing = [] {};
+
+  PrintCsvHeader(options, "elements,grain,std_seconds,speedup");
+  for (const std::string& algorithm: algorithms) {
+    for (const size_t num_workers: options.threads) {
+      ThreadPoolOptions pool_options{num_workers, num_workers};
+      pool_options.pin_to_cpus = options.pin;
+      ThreadPool<> pool(pool_options);
+      for (size_t run = 0; run < options.runs; ++run) {
+        double std_seconds = 0;
+        double seconds = 0;
+        bool correct = true;
+        if (algorithm == "for") {
+          std_seconds = Seconds(reset, [&] {
+            std::for_each(data.begin(), data.end(), [](uint64_t& x) { x = Mix(x); });
+          });
+          seconds = Seconds(reset, [&] {
+            ParallelFor(pool, size_t(0), num_elements, [&data](const size_t i) { data[i] = Mix(data[i]); },
+                        grain);
+          });
+          correct = data == expected_output;
+        } else if (algorithm == "reduce") {
+          uint64_t sum = 0;
+          std_seconds = Seconds(nothing, [&] { sink = std::accumulate(input.begin(), input.end(), uint64_t(0)); });
+          seconds = Seconds(nothing, [&] {
+            sum = ParallelReduce(pool, input.begin(), input.end(), uint64_t(0), std::plus<uint64_t>(), grain);
+          });
+          correct = sum == expected_sum;
+        } else if (algorithm == "transform") {
+          std_seconds = Seconds(nothing, [&] { std::transform(input.begin(), input.end(), output.begin(), Mix); });
+          std::fill(output.begin(), output.end(), 0);
+          seconds = Seconds(nothing, [&] {
+            ParallelTransform(pool, input.begin(), input.end(), output.begin(), Mix, grain);
+          });
+          correct = output == expected_output;
+        } else {
+          std_seconds = Seconds(reset, [&] { std::sort(data.begin(), data.end()); });
+          seconds = Seconds(reset, [&] {
+            ParallelSort(pool, data.begin(), data.end(), std::less<uint64_t>(), grain);
+          });
+          correct = data == sorted;
+        }
+        if (!correct) {
+          std::cerr << "parallel " << algorithm << " result differs from std::\n";
+          return 1;
+        }
+        PrintCsvRow("parallel-" + algorithm, algorithm, options, run,
+                    TimedResult(num_workers, num_elements, seconds),
+                    CsvFields(num_elements, grain, std_seconds, std_seconds / seconds));
+      }
+    }
+  }
+  return 0;
+}
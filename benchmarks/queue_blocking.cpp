@@ -0,0 +1,31 @@
+//
+//  queue_blocking.cpp
+//  Benchmarks
+//
+//  BlockingQueue (task-3-A). Get() blocks on an empty queue, so instead of
+//  the push/pop mix every operation is a Put followed by a Get.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      // Every thread has at most one element in flight, so Put never blocks.
+      BlockingQueue<int> queue(num_threads);
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        int value = 0;
+        for (size_t i = begin; i < end; ++i) {
+          queue.Put(static_cast<int>(thread));
+          queue.Get(value);
+        }
+      });
+      PrintCsvRow("queue-3-a", "put-get", options, run, result);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+//
+//  queue_latency.cpp
+//  Benchmarks
+//
+//  Per-operation latency of LockFreeQueue and WaitFreeQueue (task-7-B)
+//  under the queue workload of harness.h. Throughput hides the tail:
+//  an operation that keeps losing its CAS shows up only in the high percentiles
+//  and the maximum. The first argument picks the variant: "lock-free"
+//  (the default) or "wait-free".
+//
+//  Output: CSV with nanosecond percentiles over all measured operations.
+//
+
+#include "solution.h"
+#include "wait_free_queue.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+template <class Queue>
+void RunLatency(const std::string& name, int argc, char** argv) {
+  using Clock = std::chrono::steady_clock;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  if (options.header) {
+    std::cout << "benchmark,threads,run,push_ratio,pinned,ops,mops_per_sec,"
+              << "p50_ns,p99_ns,p99_9_ns,p99_99_ns,max_ns\n";
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::vector<std::vector<Operation>> operations;
+      std::vector<std::vector<uint64_t>> latencies(num_threads);
+      for (size_t i = 0; i < num_threads; ++i) {
+        operations.push_back(DrawOperations(options.warmup_ops + options.ops_per_thread, options.key_range,
+                                            {options.push_ratio, 1 - options.push_ratio}, run * 1000 + i + 1));
+        latencies[i].reserve(options.ops_per_thread);
+      }
+      auto queue = std::make_unique<Queue>();
+      for (size_t i = 0; i < options.key_range; ++i) {
+        queue->Enqueue(static_cast<int>(i));
+      }
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        const bool measured = begin >= options.warmup_ops;
+        int value = 0;
+        for (size_t i = begin; i < end; ++i) {
+          const Operation& operation = operations[thread][i];
+          const Clock::time_point start = Clock::now();
+          if (operation.kind == 0) {
+            queue->Enqueue(operation.key);
+          } else {
+            queue->Dequeue(value);
+          }
+          if (measured) {
+            latencies[thread].push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - start).count());
+          }
+        }
+      });
+      std::vector<uint64_t> all;
+      for (const std::vector<uint64_t>& thread: latencies) {
+        all.insert(all.end(), thread.begin(), thread.end());
+      }
+      std::sort(all.begin(), all.end());
+      auto percentile = [&all](const double fraction) {
+        return all.empty() ? 0 : all[std::min(all.size() - 1, static_cast<size_t>(fraction * all.size()))];
+      };
+      std::cout << name << "," << num_threads << "," << run << "," << options.push_ratio << ","
+                << (options.pin ? 1 : 0) << "," << result.ops << "," << result.ops / result.seconds / 1e6 << ","
+                << percentile(0.5) << "," << percentile(0.99) << "," << percentile(0.999) << ","
+                << percentile(0.9999) << "," << (all.empty() ? 0 : all.back()) << "\n";
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "lock-free";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "lock-free") {
+    RunLatency<LockFreeQueue<int>>("queue-7-b", argc, argv);
+  } else if (variant == "wait-free") {
+    RunLatency<WaitFreeQueue<int>>("queue-7-b-wait-free", argc, argv);
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
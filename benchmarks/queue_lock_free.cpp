@@ -0,0 +1,18 @@
+//
+//  queue_lock_free.cpp
+//  Benchmarks
+//
+//  LockFreeQueue (task-7-B).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunContainerBenchmark("queue-7-b", "queue", argc, argv,
+                        [] { return std::make_unique<LockFreeQueue<int>>(); },
+                        [](LockFreeQueue<int>& queue, const int value) { queue.Enqueue(value); },
+                        [](LockFreeQueue<int>& queue, int& value) { return queue.Dequeue(value); });
+  return 0;
+}
@@ -0,0 +1,18 @@
+//
+//  queue_wait_free.cpp
+//  Benchmarks
+//
+//  WaitFreeQueue (task-7-B).
+//
+
+#include "wait_free_queue.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunContainerBenchmark("queue-7-b-wait-free", "queue", argc, argv,
+                        [] { return std::make_unique<WaitFreeQueue<int>>(); },
+                        [](WaitFreeQueue<int>& queue, const int value) { queue.Enqueue(value); },
+                        [](WaitFreeQueue<int>& queue, int& value) { return queue.Dequeue(value); });
+  return 0;
+}
@@ -0,0 +1,108 @@
+//
+//  robot_steps.cpp
+//  Benchmarks
+//
+//  Steps per second of the two-legged Robot of task-2-B-semaphore, logging
+//  every step either through StepLogSink or the way Robot did before,
+//  with std::endl under the semaphore handoff. Both write to /dev/null,
+//  so the terminal stays out of the measurement. Two threads, one per leg,
+//  make --ops steps each; --threads is ignored.
+//  The first argument picks the variant: "sink" (the default) or "cout".
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct SinkLog {
+  StepLogSink sink_;
+
+  explicit SinkLog(std::ostream& out) : sink_(out) {}
+
+  void Log(const char* message) {
+    sink_.Log(message);
+  }
+};
+
+struct StreamLog {
+  std::ostream& out_;
+
+  explicit StreamLog(std::ostream& out) : out_(out) {}
+
+  void Log(const char* message) {
+    out_ << message << std::endl;
+  }
+};
+
+// Robot of task-2-B-semaphore with the logging made pluggable.
+template <class Log>
+class LoggingRobot {
+ public:
+  explicit LoggingRobot(std::ostream& out) : log_(out) {}
+
+  void StepLeft() {
+    left_semaphore_.Wait();
+    log_.Log("left");
+    right_semaphore_.Signal();
+  }
+
+  void StepRight() {
+    right_semaphore_.Wait();
+    log_.Log("right");
+    left_semaphore_.Signal();
+  }
+
+ private:
+  Semaphore left_semaphore_{1};
+  Semaphore right_semaphore_;
+  Log log_;
+};
+
+template <class Log>
+void RunStepsBenchmark(const std::string& name, int argc, char** argv) {
+  BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  options.threads = {2};
+  PrintCsvHeader(options);
+  std::ofstream null_stream("/dev/null");
+  for (size_t run = 0; run < options.runs; ++run) {
+    RunResult result;
+    {
+      LoggingRobot<Log> robot(null_stream);
+      result = RunThreads(options, 2, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (thread == 0) {
+            robot.StepLeft();
+          } else {
+            robot.StepRight();
+          }
+        }
+      });
+      // The sink still writes the tail of the log in its destructor,
+      // which is outside of the measurement, like a flush at exit.
+    }
+    PrintCsvRow(name, "steps", options, run, result);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "sink";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "sink") {
+    RunStepsBenchmark<SinkLog>("robot-2-b-sink", argc, argv);
+  } else if (variant == "cout") {
+    RunStepsBenchmark<StreamLog>("robot-2-b-cout", argc, argv);
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,63 @@
+//
+//  semaphore_handoff.cpp
+//  Benchmarks
+//
+//  Semaphore of task-2-B-semaphore against the mutex + condition variable
+//  semaphore it replaced. --threads participants pass a single permit around
+//  a ring of semaphores, as Robot does with two: participant i waits on
+//  semaphore i and signals semaphore i + 1. Handoffs are sequential, so
+//  1000 / mops_per_sec is the handoff latency in nanoseconds; with one
+//  thread every Wait and Signal takes the uncontended path.
+//  The first argument picks the variant: "futex" (the default) or "mutex".
+//
+
+#include "solution.h"
+
+#include "harness.h"
+#include "mutex_semaphore.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+template <class SemaphoreType>
+void RunHandoffBenchmark(const std::string& name, int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::vector<std::unique_ptr<SemaphoreType>> ring;
+      for (size_t i = 0; i < num_threads; ++i) {
+        ring.push_back(std::make_unique<SemaphoreType>(i == 0 ? 1 : 0));
+      }
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        SemaphoreType& mine = *ring[thread];
+        SemaphoreType& next = *ring[(thread + 1) % num_threads];
+        for (size_t i = begin; i < end; ++i) {
+          mine.Wait();
+          next.Signal();
+        }
+      });
+      PrintCsvRow(name, "handoff-ring", options, run, result);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "futex";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "futex") {
+    RunHandoffBenchmark<Semaphore>("semaphore-2-b-futex", argc, argv);
+  } else if (variant == "mutex") {
+    RunHandoffBenchmark<MutexSemaphore>("semaphore-2-b-mutex", argc, argv);
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
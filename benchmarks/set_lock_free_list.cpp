@@ -0,0 +1,34 @@
+//
+//  set_lock_free_list.cpp
+//  Benchmarks
+//
+//  LockFreeLinkedSet (task-7-C).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+struct ArenaBackedSet {
+  ArenaAllocator allocator_;
+  ConcurrentSet<int> set_{allocator_};
+  
+  bool Insert(const int key) {
+    return set_.Insert(key);
+  }
+  
+  bool Remove(const int key) {
+    return set_.Remove(key);
+  }
+  
+  bool Contains(const int key) {
+    return set_.Contains(key);
+  }
+};
+
+int main(int argc, char** argv) {
+  RunSetBenchmark("set-7-c", argc, argv, [] {
+    return std::make_unique<ArenaBackedSet>();
+  });
+  return 0;
+}
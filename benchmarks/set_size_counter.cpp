@@ -0,0 +1,74 @@
+//
+//  set_size_counter.cpp
+//  Benchmarks
+//
+//  Update-heavy workload on one of the sets with the element counter
+//  it ships with (ShardedCounter) or with a single shared atomic
+//  (SharedCounter). Built once per set: SIZE_COUNTER_SET_4_A, _4_B or _7_C
+//  picks the task. The first argument picks the counter: "sharded"
+//  (the default) or "shared". Run with --read-ratio=0 to make every
+//  operation an insert or a remove.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#if defined(SIZE_COUNTER_SET_4_A)
+template <class Counter> using CountedSet = StripedHashSet<int, std::hash<int>, std::mutex, Counter>;
+static const char* const kSetName = "set-4-a";
+#elif defined(SIZE_COUNTER_SET_4_B)
+template <class Counter> using CountedSet = OptimisticLinkedSet<int, SpinLock, Counter>;
+static const char* const kSetName = "set-4-b";
+#else
+template <class Counter> using CountedSet = LockFreeLinkedSet<int, AtomicMarkedPointer, Counter>;
+static const char* const kSetName = "set-7-c";
+#endif
+
+template <class Counter>
+struct BenchmarkedSet {
+#if defined(SIZE_COUNTER_SET_4_A)
+  CountedSet<Counter> set_{16};
+#else
+  ArenaAllocator allocator_;
+  CountedSet<Counter> set_{allocator_};
+#endif
+  
+  bool Insert(const int key) {
+    return set_.Insert(key);
+  }
+  
+  bool Remove(const int key) {
+    return set_.Remove(key);
+  }
+  
+  bool Contains(const int key) {
+    return set_.Contains(key);
+  }
+};
+
+int main(int argc, char** argv) {
+  std::string variant = "sharded";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant == "sharded") {
+    RunSetBenchmark(std::string(kSetName) + "-sharded-size", argc, argv, [] {
+      return std::make_unique<BenchmarkedSet<ShardedCounter>>();
+    });
+  } else if (variant == "shared") {
+    RunSetBenchmark(std::string(kSetName) + "-shared-size", argc, argv, [] {
+      return std::make_unique<BenchmarkedSet<SharedCounter>>();
+    });
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
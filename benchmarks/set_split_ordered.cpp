@@ -0,0 +1,35 @@
+//
+//  set_split_ordered.cpp
+//  Benchmarks
+//
+//  SplitOrderedHashSet (task-7-C). Compare with bench-set-4-a at the same
+//  --read-ratio, e.g. 0.9 for a lookup-heavy and 0.1 for an insert-heavy mix.
+//
+
+#include "split_ordered_set.h"
+
+#include "harness.h"
+
+struct ArenaBackedSet {
+  ArenaAllocator allocator_;
+  SplitOrderedHashSet<int> set_{allocator_};
+  
+  bool Insert(const int key) {
+    return set_.Insert(key);
+  }
+  
+  bool Remove(const int key) {
+    return set_.Remove(key);
+  }
+  
+  bool Contains(const int key) {
+    return set_.Contains(key);
+  }
+};
+
+int main(int argc, char** argv) {
+  RunSetBenchmark("set-7-c-split-ordered", argc, argv, [] {
+    return std::make_unique<ArenaBackedSet>();
+  });
+  return 0;
+}
@@ -0,0 +1,17 @@
+//
+//  set_striped.cpp
+//  Benchmarks
+//
+//  StripedHashSet with std::mutex stripes (task-4-A).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunSetBenchmark("set-4-a", argc, argv, [] {
+    return std::make_unique<ConcurrentSet<int>>(16);
+  });
+  return 0;
+}
@@ -0,0 +1,67 @@
+//
+//  set_striped_strings.cpp
+//  Benchmarks
+//
+//  StripedHashSet (task-4-A) with 64-byte string keys that share a long
+//  prefix, so every element comparison that the stored hashes don't
+//  rule out costs a full 64-byte compare.
+//
+//  Every run first fills an empty set with --key-range keys on one thread
+//  and reports that as the "fill" workload: its time is mostly the resizes.
+//  Then the threads look up keys drawn from twice the key range (so about
+//  half of the lookups miss), reported as the "lookup" workload.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::string MakeKey(const size_t index) {
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), "%016zx", index);
+  std::string key(64 - 16, 'k');
+  return key + suffix;
+}
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  std::vector<std::string> keys(2 * options.key_range);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    keys[i] = MakeKey(i);
+  }
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      auto set = std::make_unique<StripedHashSet<std::string>>(16);
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < options.key_range; ++i) {
+        set->Insert(keys[i]);
+      }
+      RunResult fill;
+      fill.threads = 1;
+      fill.ops = options.key_range;
+      fill.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      fill.has_counters = false;
+      PrintCsvRow("set-4-a-strings", "fill", options, run, fill);
+
+      std::vector<std::vector<Operation>> operations;
+      for (size_t i = 0; i < num_threads; ++i) {
+        operations.push_back(DrawOperations(options.warmup_ops + options.ops_per_thread, keys.size(),
+                                            {1}, run * 1000 + i + 1));
+      }
+      const RunResult lookup = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          set->Contains(keys[operations[thread][i].key]);
+        }
+      });
+      PrintCsvRow("set-4-a-strings", "lookup", options, run, lookup);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,18 @@
+//
+//  stack_lock_free.cpp
+//  Benchmarks
+//
+//  LockFreeStack (task-7-A).
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+int main(int argc, char** argv) {
+  RunContainerBenchmark("stack-7-a", "stack", argc, argv,
+                        [] { return std::make_unique<ConcurrentStack<int>>(); },
+                        [](ConcurrentStack<int>& stack, const int value) { stack.Push(value); },
+                        [](ConcurrentStack<int>& stack, int& value) { return stack.Pop(value); });
+  return 0;
+}
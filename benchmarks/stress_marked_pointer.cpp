@@ -0,0 +1,130 @@
+//
+//  stress_marked_pointer.cpp
+//  Benchmarks
+//
+//  Stress test of TaggedAtomicMarkedPointer and VersionedAtomicMarkedPointer
+//  (task-7-C). Writers move the pointer around a ring of nodes with CAS,
+//  always setting the mark to the parity of the node index, while readers
+//  check every Load() for a torn (pointer, mark) pair and for a version that
+//  goes back. At the end the position on the ring (and, for the versioned
+//  variant, the version) must match the number of successful CAS: none was
+//  lost or applied twice. A single-threaded A -> B -> A scenario checks that
+//  only the versioned variant rejects a stale expected value.
+//
+//  Accepts the options of harness.h except --warmup; --threads counts
+//  the writers, and as many readers run alongside. Exits with 1 on the first
+//  violation.
+//
+
+#include "atomic_marked_pointer.h"
+
+#include "harness.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Node {
+  size_t index_;
+};
+
+static void Fail(const std::string& name, const std::string& what) {
+  std::cerr << name << ": " << what << "\n";
+  std::exit(1);
+}
+
+template <template <typename U> class MarkedAtomic, bool kVersioned>
+void Stress(const std::string& name, const BenchmarkOptions& options) {
+  using MarkedPointer = typename MarkedAtomic<Node>::MarkedPointer;
+  // Even, so that the mark alternates all the way around the ring.
+  std::vector<Node> nodes(std::max<size_t>(4, options.key_range & ~size_t(1)));
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    nodes[i].index_ = i;
+  }
+
+  {
+    MarkedAtomic<Node> pointer(&nodes[0], false);
+    const MarkedPointer loaded = pointer.Load();
+    pointer.Store(&nodes[1], true);
+    pointer.Store(&nodes[0], false);
+    if (pointer.CompareAndSet(loaded, {&nodes[2], false}) == kVersioned) {
+      Fail(name, kVersioned ? "stale CAS succeeded after A -> B -> A" : "CAS of an equal value failed");
+    }
+  }
+
+  for (const size_t num_writers: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      MarkedAtomic<Node> pointer(&nodes[0], false);
+      std::atomic<size_t> successes{0};
+      std::atomic<size_t> writers_left{num_writers};
+
+      auto reader = [&] {
+        uint64_t last_version = 0;
+        while (writers_left.load() != 0) {
+          const MarkedPointer current = pointer.Load();
+          if (current.marked_ != (current.ptr_->index_ % 2 == 1)) {
+            Fail(name, "torn (pointer, mark) pair");
+          }
+          if (pointer.LoadPointer()->index_ >= nodes.size()) {
+            Fail(name, "LoadPointer() returned a pointer with the mark bit");
+          }
+          if constexpr (kVersioned) {
+            if (current.version_ < last_version) {
+              Fail(name, "version went back");
+            }
+            last_version = current.version_;
+          }
+        }
+      };
+      auto writer = [&] {
+        size_t done = 0;
+        for (size_t i = 0; i < options.ops_per_thread; ++i) {
+          const MarkedPointer current = pointer.Load();
+          const size_t next = (current.ptr_->index_ + 1) % nodes.size();
+          MarkedPointer desired = current;
+          desired.ptr_ = &nodes[next];
+          desired.marked_ = next % 2 == 1;
+          if (pointer.CompareAndSet(current, desired)) {
+            ++done;
+          }
+        }
+        successes.fetch_add(done);
+        writers_left.fetch_sub(1);
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < num_writers; ++i) {
+        threads.emplace_back(reader);
+        threads.emplace_back(writer);
+      }
+      for (std::thread& thread: threads) {
+        thread.join();
+      }
+
+      const MarkedPointer last = pointer.Load();
+      const size_t total = successes.load();
+      if (last.ptr_->index_ != total % nodes.size()) {
+        Fail(name, "pointer at node " + std::to_string(last.ptr_->index_) + " after " +
+                   std::to_string(total) + " successful CAS");
+      }
+      if constexpr (kVersioned) {
+        if (last.version_ != total) {
+          Fail(name, "version " + std::to_string(last.version_) + " after " +
+                     std::to_string(total) + " successful CAS");
+        }
+      }
+      std::cout << name << ": " << num_writers << " writers, " << num_writers << " readers, "
+                << total << " successful CAS: ok\n";
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  Stress<TaggedAtomicMarkedPointer, false>("marked-pointer-tagged", options);
+  Stress<VersionedAtomicMarkedPointer, true>("marked-pointer-versioned", options);
+  return 0;
+}
@@ -0,0 +1,109 @@
+//
+//  stress_timeout_mcs.cpp
+//  Benchmarks
+//
+//  Abort churn on TimeoutMCSLock (task-5-A). Every thread mixes Acquire(),
+//  TryAcquire() and TryAcquireFor() with timeouts of 0 to 20 us, so most timed
+//  attempts give up and leave their nodes in the queue for the releasers
+//  to skip. Checks that no two threads are ever inside at once, that every
+//  successful acquisition is counted exactly once, and that the lock is free
+//  once all threads are done (a broken chain would hang the test instead).
+//
+//  Accepts the options of harness.h except --warmup. Exits with 1
+//  on the first violation.
+//
+
+#include "timeout_mcs_lock.h"
+
+#include "harness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+static void Fail(const std::string& what) {
+  std::cerr << "timeout-mcs: " << what << "\n";
+  std::exit(1);
+}
+
+int main(int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      TimeoutMCSLock lock;
+      std::atomic<bool> inside{false};
+      // Protected by the lock.
+      size_t counter = 0;
+      std::atomic<size_t> acquired{0};
+      std::atomic<size_t> aborted{0};
+
+      auto critical_section = [&] {
+        if (inside.exchange(true)) {
+          Fail("two threads in the critical section");
+        }
+        ++counter;
+        for (size_t j = 0; j < options.cs_work; ++j) {
+          __asm__ __volatile__("" : : : "memory");
+        }
+        // Now and then the owner lets the others run while it holds the lock,
+        // so that their timed attempts really time out, even on a single CPU.
+        if (counter % 32 == 0) {
+          std::this_thread::yield();
+        }
+        inside.store(false);
+      };
+
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([&, i] {
+          std::mt19937 generator(static_cast<unsigned>(run * 1000 + i + 1));
+          std::uniform_int_distribution<int> kinds(0, 19);
+          std::uniform_int_distribution<int> timeouts_us(0, 20);
+          size_t my_acquired = 0;
+          size_t my_aborted = 0;
+          for (size_t op = 0; op < options.ops_per_thread; ++op) {
+            const int kind = kinds(generator);
+            bool ok = true;
+            if (kind == 0) {
+              TimeoutMCSLock::Guard guard(lock);
+              critical_section();
+            } else if (kind == 1) {
+              ok = lock.TryAcquire();
+            } else {
+              ok = lock.TryAcquireFor(std::chrono::microseconds(timeouts_us(generator)));
+            }
+            if (ok && kind != 0) {
+              critical_section();
+              lock.Release();
+            }
+            ++(ok ? my_acquired : my_aborted);
+            // Think time. It also lets a preempted owner run when the threads
+            // outnumber the CPUs; otherwise every waiter spins for a whole time slice.
+            std::this_thread::yield();
+          }
+          acquired.fetch_add(my_acquired);
+          aborted.fetch_add(my_aborted);
+        });
+      }
+      for (std::thread& thread: threads) {
+        thread.join();
+      }
+
+      if (counter != acquired.load()) {
+        Fail("counted " + std::to_string(counter) + " critical sections for " +
+             std::to_string(acquired.load()) + " acquisitions");
+      }
+      if (!lock.TryAcquire()) {
+        Fail("lock is not free after all threads are done");
+      }
+      lock.Release();
+      std::cout << "timeout-mcs: " << num_threads << " threads, " << acquired.load() << " acquired, "
+                << aborted.load() << " gave up: ok\n";
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+//
+//  thread_pool_allocations.cpp
+//  Benchmarks
+//
+//  Heap allocations per task and submit-to-complete latency of ThreadPool
+//  (task-3-B) on empty int-returning tasks. Global operator new is replaced
+//  by a counting one, so every allocation of the program is seen, including
+//  the ones made by the workers and by the queue.
+//
+//  The first argument picks how a task is submitted: "submit" (the default)
+//  through Submit(f), which stores the callable inline in a Task and takes
+//  the promise state from PoolAllocator; "async" through Async(f), which returns
+//  a Future; or "packaged-task", which wraps the callable into
+//  std::function and std::packaged_task as the pool did before.
+//
+//  Every run submits --ops tasks and waits for all of them, then runs
+//  --ops / 10 tasks one by one to measure the latency. --warmup tasks run
+//  before the first run of every pool, to fill the allocator's free lists.
+//
+//  Output: the CSV of harness.h; threads is the number of workers.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+static std::atomic<size_t> allocations{0};
+
+// GCC takes the replaced operator new for the builtin one and warns
+// that its memory is released with free().
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+using Clock = std::chrono::steady_clock;
+
+// Submits count empty tasks and waits for all of them. With one_by_one
+// every task is waited for before the next one is submitted.
+static void RunTasks(ThreadPool<>& pool, const std::string& variant, const size_t count,
+                     const bool one_by_one) {
+  std::vector<std::future<int>> futures;
+  std::vector<Future<int>> pool_futures;
+  futures.reserve(count);
+  pool_futures.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto empty = [i] { return static_cast<int>(i); };
+    if (variant == "submit") {
+      futures.push_back(pool.Submit(empty));
+    } else if (variant == "async") {
+      pool_futures.push_back(pool.Async(empty));
+    } else {
+      std::packaged_task<int()> task(std::function<int()>{empty});
+      futures.push_back(task.get_future());
+      pool.Execute(Task(std::move(task)));
+    }
+    if (one_by_one) {
+      futures.empty() ? pool_futures.back().Get() : futures.back().get();
+    }
+  }
+  if (!one_by_one) {
+    for (auto& future: futures) {
+      future.get();
+    }
+    for (auto& future: pool_futures) {
+      future.Get();
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "submit";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant != "submit" && variant != "async" && variant != "packaged-task") {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  BenchmarkOptions defaults;
+  defaults.threads = {4};
+  defaults.ops_per_thread = 100000;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  const size_t num_tasks = std::max<size_t>(options.ops_per_thread, 1);
+
+  PrintCsvHeader(options, "allocations_per_task,mean_latency_us,p99_latency_us");
+  for (const size_t num_workers: options.threads) {
+    ThreadPoolOptions pool_options{num_workers, num_workers};
+    pool_options.pin_to_cpus = options.pin;
+    ThreadPool<> pool(pool_options);
+    RunTasks(pool, variant, options.warmup_ops, false);
+    for (size_t run = 0; run < options.runs; ++run) {
+      const size_t before = allocations.load();
+      const Clock::time_point start = Clock::now();
+      RunTasks(pool, variant, num_tasks, false);
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      const double per_task = static_cast<double>(allocations.load() - before) / num_tasks;
+
+      std::vector<double> latencies;
+      for (size_t i = 0; i < std::max<size_t>(num_tasks / 10, 1); ++i) {
+        const Clock::time_point submitted = Clock::now();
+        RunTasks(pool, variant, 1, true);
+        latencies.push_back(std::chrono::duration<double, std::micro>(Clock::now() - submitted).count());
+      }
+      double sum = 0;
+      for (const double latency: latencies) {
+        sum += latency;
+      }
+      std::sort(latencies.begin(), latencies.end());
+      PrintCsvRow("thread-pool-allocations-" + variant, "empty-tasks", options, run,
+                  TimedResult(num_workers, num_tasks, seconds),
+                  CsvFields(per_task, sum / latencies.size(),
+                            latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))]));
+    }
+  }
+  return 0;
+}
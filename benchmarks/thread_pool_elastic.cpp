@@ -0,0 +1,95 @@
+//
+//  thread_pool_elastic.cpp
+//  Benchmarks
+//
+//  Throughput of ThreadPool (task-3-B) on bursts of --ops tasks that mix
+//  CPU work with blocking calls: every --blocking-every-th task sleeps
+//  --sleep-us microseconds inside a BlockingRegion, the rest spin for
+//  --task-us microseconds. Every run is one burst. After it the pool stays
+//  idle for twice the idle timeout, and the number of workers is reported
+//  before and after that pause, which shows the pool growing under the burst
+//  and shrinking back.
+//
+//  The first argument picks the pool: "elastic" (the default) with
+//  min_workers = threads and max_workers = 16 * threads, or "fixed"
+//  with threads workers.
+//
+//  Output: the CSV of harness.h; threads is the minimum number of workers.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static void BusyWork(const std::chrono::microseconds duration) {
+  const Clock::time_point until = Clock::now() + duration;
+  while (Clock::now() < until) {
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "elastic";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant != "elastic" && variant != "fixed") {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  BenchmarkOptions defaults;
+  defaults.threads = {4};
+  defaults.ops_per_thread = 2000;
+  defaults.task_us = 20;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  const size_t num_tasks = options.ops_per_thread;
+  const std::chrono::microseconds sleep(options.sleep_us);
+  const std::chrono::microseconds work(options.task_us);
+
+  PrintCsvHeader(options, "blocking_every,sleep_us,task_us,workers_after_burst,workers_after_idle");
+  for (const size_t num_workers: options.threads) {
+    ThreadPoolOptions pool_options;
+    pool_options.min_workers = num_workers;
+    pool_options.max_workers = variant == "elastic" ? 16 * num_workers : num_workers;
+    pool_options.idle_timeout = std::chrono::milliseconds(100);
+    pool_options.pin_to_cpus = options.pin;
+    ThreadPool<> pool(pool_options);
+    for (size_t run = 0; run < options.runs; ++run) {
+      std::atomic<size_t> done{0};
+      const Clock::time_point start = Clock::now();
+      for (size_t i = 0; i < num_tasks; ++i) {
+        const bool blocking = i % options.blocking_every == 0;
+        pool.Execute(Task([&pool, &done, blocking, sleep, work] {
+          if (blocking) {
+            ThreadPool<>::BlockingRegion region(pool);
+            std::this_thread::sleep_for(sleep);
+          } else {
+            BusyWork(work);
+          }
+          done.fetch_add(1);
+        }));
+      }
+      while (done.load() != num_tasks) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      const size_t workers_after_burst = pool.NumWorkers();
+      std::this_thread::sleep_for(2 * pool_options.idle_timeout);
+      PrintCsvRow("thread-pool-elastic-" + variant, "burst", options, run,
+                  TimedResult(num_workers, num_tasks, seconds),
+                  CsvFields(options.blocking_every, options.sleep_us, options.task_us, workers_after_burst,
+                            pool.NumWorkers()));
+    }
+  }
+  return 0;
+}
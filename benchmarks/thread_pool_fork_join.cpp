@@ -0,0 +1,140 @@
+//
+//  thread_pool_fork_join.cpp
+//  Benchmarks
+//
+//  Fork-join parallel recursive sum on ThreadPool (task-3-B): the sum of
+//  [lo, hi) forks the right half as a task, computes the left half itself
+//  and joins the right one, down to --grain elements (of --elements).
+//  The recursion is deeper than the number of workers, so every worker ends
+//  up waiting for a task that is still queued.
+//
+//  The first argument picks how the join waits: "future" (the default)
+//  forks with Async() and joins with Future::Get(), which runs queued tasks
+//  while waiting; "std-future" forks with Submit() and joins with
+//  std::future::get(), which blocks the worker. The latter deadlocks as soon
+//  as all workers are blocked: the benchmark then reports the run as stalled
+//  after a few seconds and exits without shutting the pool down.
+//
+//  Output: the CSV of harness.h, one operation per leaf task; threads is
+//  the number of workers.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static uint64_t SumWithFutures(ThreadPool<>& pool, const std::vector<uint64_t>& values, const size_t lo,
+                               const size_t hi, const size_t grain) {
+  if (hi - lo <= grain) {
+    uint64_t sum = 0;
+    for (size_t i = lo; i < hi; ++i) {
+      sum += values[i];
+    }
+    return sum;
+  }
+  const size_t mid = lo + (hi - lo) / 2;
+  Future<uint64_t> right = pool.Async([&pool, &values, mid, hi, grain] {
+    return SumWithFutures(pool, values, mid, hi, grain);
+  });
+  const uint64_t left = SumWithFutures(pool, values, lo, mid, grain);
+  return left + right.Get();
+}
+
+static uint64_t SumWithStdFutures(ThreadPool<>& pool, const std::vector<uint64_t>& values, const size_t lo,
+                                  const size_t hi, const size_t grain) {
+  if (hi - lo <= grain) {
+    uint64_t sum = 0;
+    for (size_t i = lo; i < hi; ++i) {
+      sum += values[i];
+    }
+    return sum;
+  }
+  const size_t mid = lo + (hi - lo) / 2;
+  std::future<uint64_t> right = pool.Submit([&pool, &values, mid, hi, grain] {
+    return SumWithStdFutures(pool, values, mid, hi, grain);
+  });
+  const uint64_t left = SumWithStdFutures(pool, values, lo, mid, grain);
+  return left + right.get();
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "future";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant != "future" && variant != "std-future") {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  BenchmarkOptions defaults;
+  defaults.threads = {4};
+  defaults.runs = 5;
+  defaults.elements = 10000000;
+  defaults.grain = 10000;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  const size_t num_elements = options.elements;
+  const size_t grain = std::max<size_t>(options.grain, 1);
+
+  std::vector<uint64_t> values(num_elements);
+  for (size_t i = 0; i < num_elements; ++i) {
+    values[i] = i % 1000;
+  }
+  const uint64_t expected = [&values] {
+    uint64_t sum = 0;
+    for (const uint64_t value: values) {
+      sum += value;
+    }
+    return sum;
+  }();
+
+  PrintCsvHeader(options, "elements,grain,stalled");
+  const std::string name = "thread-pool-fork-join-" + variant;
+  const size_t num_tasks = (num_elements + grain - 1) / grain;
+  for (const size_t num_workers: options.threads) {
+    ThreadPoolOptions pool_options{num_workers, num_workers};
+    pool_options.pin_to_cpus = options.pin;
+    ThreadPool<> pool(pool_options);
+    for (size_t run = 0; run < options.runs; ++run) {
+      const Clock::time_point start = Clock::now();
+      // The root runs on a worker too, so that every join is a join inside the pool.
+      uint64_t sum = 0;
+      if (variant == "future") {
+        sum = pool.Async([&] { return SumWithFutures(pool, values, 0, num_elements, grain); }).Get();
+      } else {
+        std::future<uint64_t> root = pool.Submit([&] {
+          return SumWithStdFutures(pool, values, 0, num_elements, grain);
+        });
+        if (root.wait_for(std::chrono::seconds(5)) == std::future_status::timeout) {
+          const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+          PrintCsvRow(name, "fork-join-sum", options, run, TimedResult(num_workers, 0, seconds),
+                      CsvFields(num_elements, grain, 1));
+          std::cout.flush();
+          std::_Exit(0);
+        }
+        sum = root.get();
+      }
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      if (sum != expected) {
+        std::cerr << "wrong sum " << sum << ", expected " << expected << "\n";
+        return 1;
+      }
+      PrintCsvRow(name, "fork-join-sum", options, run, TimedResult(num_workers, num_tasks, seconds),
+                  CsvFields(num_elements, grain, 0));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+//
+//  thread_pool_metrics.cpp
+//  Benchmarks
+//
+//  Overhead of the runtime metrics of ThreadPool (task-3-B). Every run
+//  measures a pool without metrics and one with them on the same workload,
+//  in alternating order: --submitters threads each submit --ops tasks (after
+//  --warmup unmeasured ones) and wait until their tasks have run. Each task
+//  spins for --task-us microseconds; with the default 0 the tasks are empty,
+//  which is the worst case for the metrics.
+//
+//  The metrics row carries overhead = (throughput without metrics) /
+//  (throughput with them) - 1 of the same run, and the queue wait and
+//  execution percentiles of the sampled tasks (cumulative over the runs).
+//  Single runs of empty tasks are noisy (two identical pools differ by up to
+//  30% on one CPU), so take the median overhead over --runs=21 or more. With
+//  the defaults (4 workers, 2 submitters, empty tasks) and with 1 worker and
+//  1 submitter the median stays within a few percent, as does --task-us=1.
+//
+//  Output: the CSV of harness.h; threads is the number of workers.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+template <bool kMetrics>
+RunResult RunPool(ThreadPool<void, kMetrics>& pool, const BenchmarkOptions& options) {
+  const std::chrono::microseconds work(options.task_us);
+  std::vector<std::atomic<size_t>> done(options.submitters);
+  RunResult result = RunThreads(options, options.submitters, [&](size_t thread, size_t begin, size_t end) {
+    std::atomic<size_t>& own = done[thread];
+    own.store(0);
+    for (size_t i = begin; i < end; ++i) {
+      pool.Execute(Task([&own, work] {
+        if (work.count() != 0) {
+          const Clock::time_point until = Clock::now() + work;
+          while (Clock::now() < until) {
+          }
+        }
+        own.fetch_add(1, std::memory_order_release);
+      }));
+    }
+    while (own.load(std::memory_order_acquire) != end - begin) {
+      std::this_thread::yield();
+    }
+  });
+  result.threads = pool.NumWorkers();
+  // The counters saw the submitters only.
+  result.has_counters = false;
+  return result;
+}
+
+int main(int argc, char** argv) {
+  BenchmarkOptions defaults;
+  defaults.submitters = 2;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  PrintCsvHeader(options, "submitters,task_us,metrics,overhead,queue_wait_p50_ns,queue_wait_p99_ns,execution_p50_ns");
+  for (const size_t num_workers: options.threads) {
+    ThreadPoolOptions pool_options{num_workers, num_workers};
+    pool_options.pin_to_cpus = options.pin;
+    ThreadPool<void, false> plain(pool_options);
+    ThreadPool<void, true> measured(pool_options);
+    for (size_t run = 0; run < options.runs; ++run) {
+      RunResult off;
+      RunResult on;
+      if (run % 2 == 0) {
+        off = RunPool(plain, options);
+        on = RunPool(measured, options);
+      } else {
+        on = RunPool(measured, options);
+        off = RunPool(plain, options);
+      }
+      // Both runs do the same number of tasks, so the throughput ratio is
+      // the ratio of the times.
+      const double overhead = off.seconds > 0 ? on.seconds / off.seconds - 1 : 0;
+      const WorkerStats total = measured.Stats().Total();
+      PrintCsvRow("thread-pool-metrics", "off", options, run, off,
+                  CsvFields(options.submitters, options.task_us, 0, "", "", "", ""));
+      PrintCsvRow("thread-pool-metrics", "on", options, run, on,
+                  CsvFields(options.submitters, options.task_us, 1, overhead, total.queue_wait.Percentile(0.5),
+                            total.queue_wait.Percentile(0.99), total.execution.Percentile(0.5)));
+    }
+  }
+  return 0;
+}
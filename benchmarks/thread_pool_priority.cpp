@@ -0,0 +1,120 @@
+//
+//  thread_pool_priority.cpp
+//  Benchmarks
+//
+//  Latency of high-priority tasks of ThreadPool (task-3-B) under a saturating
+//  low-priority background load. A background thread keeps about --backlog
+//  low tasks of --task-us microseconds each queued all the time, while
+//  the main thread submits --ops high tasks (after --warmup unmeasured ones)
+//  one after another, 1 ms apart, and measures the time from Submit() until
+//  each of them starts running.
+//
+//  The first argument picks how the background load is submitted:
+//  "priority" (the default) at TaskPriority::kLow, "far-deadlines" with
+//  deadlines an hour away, or "fifo" at the same priority as the measured
+//  tasks, which is what the pool did before priorities.
+//
+//  Output: the CSV of harness.h with microsecond percentiles of the measured
+//  tasks; threads is the number of workers.
+//
+
+#include "solution.h"
+
+#include "harness.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static void BusyWork(const std::chrono::microseconds duration) {
+  const Clock::time_point until = Clock::now() + duration;
+  while (Clock::now() < until) {
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "priority";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+  if (variant != "priority" && variant != "far-deadlines" && variant != "fifo") {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  BenchmarkOptions defaults;
+  defaults.threads = {4};
+  defaults.ops_per_thread = 500;
+  defaults.warmup_ops = 50;
+  defaults.task_us = 50;
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv, defaults);
+  const std::chrono::microseconds work(options.task_us);
+
+  PrintCsvHeader(options, "backlog,task_us,p50_us,p99_us,max_us");
+  for (const size_t num_workers: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      ThreadPoolOptions pool_options{num_workers, num_workers};
+      pool_options.pin_to_cpus = options.pin;
+      ThreadPool<> pool(pool_options);
+      std::atomic<bool> stop{false};
+      std::thread background([&] {
+        while (!stop.load()) {
+          if (pool.NumPendingTasks() >= options.backlog) {
+            std::this_thread::yield();
+            continue;
+          }
+          auto low = [work] { BusyWork(work); };
+          if (variant == "priority") {
+            pool.SubmitWithPriority(TaskPriority::kLow, low);
+          } else if (variant == "far-deadlines") {
+            pool.SubmitWithDeadline(low, Clock::now() + std::chrono::hours(1));
+          } else {
+            pool.SubmitWithPriority(TaskPriority::kHigh, low);
+          }
+        }
+      });
+      // Let the background load fill the queue.
+      while (pool.NumPendingTasks() < options.backlog) {
+        std::this_thread::yield();
+      }
+
+      const size_t total = options.warmup_ops + options.ops_per_thread;
+      std::vector<double> latencies(total);
+      Clock::time_point start;
+      for (size_t i = 0; i < total; ++i) {
+        if (i == options.warmup_ops) {
+          start = Clock::now();
+        }
+        const Clock::time_point submitted = Clock::now();
+        std::future<void> done = pool.SubmitWithPriority(TaskPriority::kHigh, [&latencies, i, submitted] {
+          latencies[i] = std::chrono::duration<double, std::micro>(Clock::now() - submitted).count();
+        });
+        done.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+      stop.store(true);
+      background.join();
+
+      latencies.erase(latencies.begin(), latencies.begin() + options.warmup_ops);
+      std::sort(latencies.begin(), latencies.end());
+      auto percentile = [&latencies](const double quantile) {
+        return latencies.empty() ? 0 : latencies[static_cast<size_t>(quantile * (latencies.size() - 1))];
+      };
+      PrintCsvRow("thread-pool-priority-" + variant, "high-behind-low", options, run,
+                  TimedResult(num_workers, options.ops_per_thread, seconds),
+                  CsvFields(options.backlog, options.task_us, percentile(0.5), percentile(0.99),
+                            latencies.empty() ? 0 : latencies.back()));
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,94 @@
+//
+//  token_ring_handoff.cpp
+//  Benchmarks
+//
+//  Handoffs per second of TokenRing (task-2-B-centipede) against the chain
+//  of mutex + condition variable semaphores Robot used before it. --threads
+//  participants take turns in strict round-robin order, one thread each,
+//  with nothing to do in their turn: every operation is one handoff.
+//  The first argument picks the variant: "token-ring" (the default)
+//  or "semaphore-chain".
+//
+//  Defaults differ from harness.h: --threads=2,4,8,16,32 and 20000 turns
+//  per participant (--ops). Any option given on the command line wins.
+//
+
+#include "token_ring.h"
+
+#include "harness.h"
+#include "mutex_semaphore.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct TokenRingTurns {
+  TokenRing ring_;
+
+  explicit TokenRingTurns(const size_t num_participants) : ring_(num_participants) {}
+
+  void Turn(const size_t participant) {
+    ring_.Acquire(participant);
+    ring_.Release(participant);
+  }
+};
+
+struct SemaphoreChainTurns {
+  std::vector<std::unique_ptr<MutexSemaphore>> semaphores_;
+
+  explicit SemaphoreChainTurns(const size_t num_participants) {
+    for (size_t i = 0; i < num_participants; ++i) {
+      semaphores_.push_back(std::make_unique<MutexSemaphore>(i == 0 ? 1 : 0));
+    }
+  }
+
+  void Turn(const size_t participant) {
+    semaphores_[participant]->Wait();
+    semaphores_[(participant + 1) % semaphores_.size()]->Signal();
+  }
+};
+
+template <class Turns>
+void RunTurnsBenchmark(const std::string& name, int argc, char** argv) {
+  const BenchmarkOptions options = BenchmarkOptions::Parse(argc, argv);
+  PrintCsvHeader(options);
+  for (const size_t num_threads: options.threads) {
+    for (size_t run = 0; run < options.runs; ++run) {
+      Turns turns(num_threads);
+      const RunResult result = RunThreads(options, num_threads, [&](size_t thread, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          turns.Turn(thread);
+        }
+      });
+      PrintCsvRow(name, "round-robin", options, run, result);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string variant = "token-ring";
+  if (argc > 1 && std::strncmp(argv[1], "--", 2) != 0) {
+    variant = argv[1];
+    --argc;
+    ++argv;
+  }
+
+  std::vector<std::string> defaults = {"--threads=2,4,8,16,32", "--ops=20000", "--warmup=2000"};
+  std::vector<char*> args = {argv[0]};
+  for (std::string& option: defaults) {
+    args.push_back(&option[0]);
+  }
+  args.insert(args.end(), argv + 1, argv + argc);
+  const int num_args = static_cast<int>(args.size());
+
+  if (variant == "token-ring") {
+    RunTurnsBenchmark<TokenRingTurns>("token-ring-2-b", num_args, args.data());
+  } else if (variant == "semaphore-chain") {
+    RunTurnsBenchmark<SemaphoreChainTurns>("semaphore-chain-2-b", num_args, args.data());
+  } else {
+    std::cerr << "unknown variant " << variant << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,29 @@
+//
+//  futex.h
+//  Common
+//
+
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////
+
+// Thin wrappers over the futex syscall (Linux only).
+// std::atomic<int> has the same layout as int, so the kernel can park on its address.
+
+// Blocks while *addr == expected. May return spuriously, so callers must recheck.
+inline void FutexWait(std::atomic<int>* addr, int expected) {
+  syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+// Wakes up to count threads blocked on addr.
+inline void FutexWake(std::atomic<int>* addr, int count) {
+  syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+///////////////////////////////////////////////////////////////////////
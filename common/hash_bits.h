@@ -0,0 +1,33 @@
+//
+//  hash_bits.h
+//  Common
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////
+
+// Finalizer of splitmix64: every bit of the result depends on every bit
+// of the argument. Hash tables that take bucket or stripe indices from
+// some of the bits of std::hash pass it through this first, since std::hash
+// of an integer is the integer itself.
+inline uint64_t MixBits(uint64_t value) {
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+// The smallest power of two not less than value (1 for 0).
+inline size_t RoundUpToPowerOfTwo(const size_t value) {
+  size_t power = 1;
+  while (power < value) {
+    power *= 2;
+  }
+  return power;
+}
+
+///////////////////////////////////////////////////////////////////////
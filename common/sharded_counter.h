@@ -0,0 +1,113 @@
+//
+//  sharded_counter.h
+//  Common
+//
+
+#pragma once
+
+#include "hash_bits.h"
+#include "thread_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Element counter of the concurrent sets, spread over padded cells.
+// A thread always adds to the cell of its ThreadIndexRegistry index modulo
+// the number of cells, so with no more live threads than cells updates never
+// share a cache line. Cells are atomic, so threads beyond that just share one.
+//
+// Sum() adds up all cells: it counts every update that completed before
+// the call, and is exact once the updates stop. Approximate() is a single
+// load of a total that every cell refreshes after its count drifts from
+// the published value by kPublishEvery; it lags behind Sum() by less than
+// kPublishEvery per cell and suits decisions like "time to resize".
+class ShardedCounter {
+ public:
+  static const int64_t kPublishEvery = 32;
+
+  // The number of cells is rounded up to a power of two.
+  explicit ShardedCounter(const size_t num_cells = DefaultCells())
+      : cells_(RoundUpToPowerOfTwo(num_cells)) {}
+
+  void Add(const int64_t delta) {
+    Cell& cell = cells_[ThreadIndexRegistry::Current() & (cells_.size() - 1)];
+    const int64_t value = cell.value_.fetch_add(delta, std::memory_order_relaxed) + delta;
+    int64_t published = cell.published_.load(std::memory_order_relaxed);
+    if (value - published >= kPublishEvery || published - value >= kPublishEvery) {
+      // Several threads may share a cell: the one that wins the CAS publishes.
+      if (cell.published_.compare_exchange_strong(published, value, std::memory_order_relaxed)) {
+        approximate_.fetch_add(value - published, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  size_t Sum() const {
+    int64_t sum = 0;
+    for (const Cell& cell: cells_) {
+      sum += cell.value_.load(std::memory_order_relaxed);
+    }
+    return static_cast<size_t>(std::max<int64_t>(sum, 0));
+  }
+
+  size_t Approximate() const {
+    return static_cast<size_t>(std::max<int64_t>(approximate_.load(std::memory_order_relaxed), 0));
+  }
+
+ private:
+  struct alignas(64) Cell {
+    // Net count of the updates made through this cell; may be negative.
+    std::atomic<int64_t> value_{0};
+    // Part of value_ already added to approximate_.
+    std::atomic<int64_t> published_{0};
+  };
+
+  static size_t DefaultCells() {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<Cell> cells_;
+  alignas(64) std::atomic<int64_t> approximate_{0};
+};
+
+// The counter the sets used to have: one atomic that every update writes.
+// Same interface as ShardedCounter, for comparison.
+class SharedCounter {
+ public:
+  void Add(const int64_t delta) {
+    value_.fetch_add(delta);
+  }
+
+  size_t Sum() const {
+    return static_cast<size_t>(std::max<int64_t>(value_.load(), 0));
+  }
+
+  size_t Approximate() const {
+    return Sum();
+  }
+
+ private:
+  std::atomic<int64_t> value_{0};
+};
+
+// Counts nothing, for a set whose owner keeps the count of its elements
+// itself. Same interface as ShardedCounter.
+class NoCounter {
+ public:
+  void Add(const int64_t) {}
+
+  size_t Sum() const {
+    return 0;
+  }
+
+  size_t Approximate() const {
+    return 0;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////
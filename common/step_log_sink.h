@@ -0,0 +1,226 @@
+//
+//  step_log_sink.h
+//  Common
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Asynchronous line logger that keeps the global order of messages.
+// Log() takes the next sequence number and puts the message into a lock-free
+// single-producer ring buffer owned by the calling thread, so logging inside
+// a critical section costs an atomic increment and a copy instead of a stream lock
+// and a flush. A background writer merges the buffers by sequence numbers
+// and writes the lines in large chunks. When there is nothing to write,
+// the writer sleeps on a condition variable; Log() wakes it up, and takes
+// the mutex for that only if the writer is actually asleep.
+// If the order of Log() calls matters (e.g. Robot steps), they have to be ordered
+// by the caller; the sink writes lines exactly in the order sequence numbers were taken.
+// All Log() calls must finish before the sink is destroyed; the destructor writes
+// everything that was logged and flushes the stream.
+class StepLogSink {
+ public:
+  static constexpr size_t kDefaultBufferCapacity = 1024;
+  static constexpr size_t kDefaultFlushThreshold = 1 << 16;
+
+  explicit StepLogSink(std::ostream& out = std::cout,
+                       const size_t buffer_capacity = kDefaultBufferCapacity,
+                       const size_t flush_threshold = kDefaultFlushThreshold)
+      : out_(out),
+        buffer_capacity_(buffer_capacity == 0 ? 1 : buffer_capacity),
+        flush_threshold_(flush_threshold),
+        id_(NextSinkId()),
+        writer_(&StepLogSink::WriterRoutine, this) {}
+
+  ~StepLogSink() {
+    {
+      std::unique_lock<std::mutex> lock(writer_mtx_);
+      stopped_.store(true);
+    }
+    writer_cv_.notify_one();
+    writer_.join();
+    Buffer* buffer = buffers_.load(std::memory_order_acquire);
+    while (buffer != nullptr) {
+      Buffer* next = buffer->next_;
+      delete buffer;
+      buffer = next;
+    }
+  }
+
+  // A message longer than a record takes several consecutive records
+  // of the caller's buffer, all with the same sequence number.
+  void Log(const std::string& message) {
+    Buffer* buffer = ThreadBuffer();
+    const uint64_t sequence = next_sequence_.fetch_add(1);
+    size_t offset = 0;
+    do {
+      const size_t length = std::min(message.size() - offset, kRecordTextLength);
+      const size_t tail = buffer->tail_.load(std::memory_order_relaxed);
+      // The writer is behind: wait for a free record.
+      while (tail - buffer->head_.load(std::memory_order_acquire) == buffer->records_.size()) {
+        std::this_thread::yield();
+      }
+      Record& record = buffer->records_[tail % buffer->records_.size()];
+      record.sequence_ = sequence;
+      record.length_ = static_cast<uint8_t>(length);
+      record.continued_ = offset + length < message.size();
+      std::memcpy(record.text_, message.data() + offset, length);
+      buffer->tail_.store(tail + 1, std::memory_order_release);
+      offset += length;
+    } while (offset < message.size());
+    WakeWriter();
+  }
+
+  StepLogSink(const StepLogSink&) = delete;
+  StepLogSink& operator=(const StepLogSink&) = delete;
+
+ private:
+  static constexpr size_t kRecordTextLength = 54;
+  // Rounds without progress the writer yields for before it goes to sleep,
+  // so that a steady stream of steps doesn't pay for a wakeup each.
+  static constexpr size_t kIdleRounds = 64;
+
+  // One cache line.
+  struct Record {
+    uint64_t sequence_;
+    uint8_t length_;
+    // The message goes on in the next record.
+    bool continued_;
+    char text_[kRecordTextLength];
+  };
+
+  // Single-producer single-consumer ring: the owning thread writes at tail_,
+  // the writer thread reads at head_.
+  struct Buffer {
+    Buffer(const size_t capacity, const std::thread::id owner)
+        : records_(capacity),
+          owner_(owner) {}
+
+    std::vector<Record> records_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+    // A thread that reuses the id of an exited owner takes the buffer over.
+    const std::thread::id owner_;
+    Buffer* next_{nullptr};
+  };
+
+  static uint64_t NextSinkId() {
+    static std::atomic<uint64_t> next_id{0};
+    return next_id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // One buffer per thread and sink. The thread-local cache remembers the last
+  // sink only; after a switch between sinks the thread finds its buffer
+  // in the sink's list again instead of registering a new one.
+  // Sink ids are never reused, so a stale cache entry of a destroyed sink
+  // can not be taken for a buffer of a new one allocated at the same address.
+  Buffer* ThreadBuffer() {
+    struct Cache {
+      uint64_t sink_id_;
+      Buffer* buffer_;
+    };
+    static thread_local Cache cache{UINT64_MAX, nullptr};
+    if (cache.sink_id_ == id_) {
+      return cache.buffer_;
+    }
+    const std::thread::id me = std::this_thread::get_id();
+    Buffer* buffer = buffers_.load(std::memory_order_acquire);
+    while (buffer != nullptr && buffer->owner_ != me) {
+      buffer = buffer->next_;
+    }
+    if (buffer == nullptr) {
+      buffer = new Buffer(buffer_capacity_, me);
+      buffer->next_ = buffers_.load(std::memory_order_relaxed);
+      while (!buffers_.compare_exchange_weak(buffer->next_, buffer, std::memory_order_release,
+                                             std::memory_order_relaxed)) {}
+    }
+    cache = {id_, buffer};
+    return buffer;
+  }
+
+  // next_sequence_ and writer_sleeping_ are seq_cst: either the writer sees
+  // our sequence number taken and doesn't fall asleep, or we see it asleep.
+  void WakeWriter() {
+    if (writer_sleeping_.load()) {
+      std::unique_lock<std::mutex> lock(writer_mtx_);
+      writer_cv_.notify_one();
+    }
+  }
+
+  // Every buffer is sorted by sequence numbers, so the next line is always
+  // at the head of one of them (or hasn't been published yet).
+  void WriterRoutine() {
+    std::string pending;
+    uint64_t expected = 0;
+    size_t idle_rounds = 0;
+    while (true) {
+      bool progress = false;
+      for (Buffer* buffer = buffers_.load(std::memory_order_acquire); buffer != nullptr;
+           buffer = buffer->next_) {
+        size_t head = buffer->head_.load(std::memory_order_relaxed);
+        while (head != buffer->tail_.load(std::memory_order_acquire)) {
+          const Record& record = buffer->records_[head % buffer->records_.size()];
+          if (record.sequence_ != expected) {
+            break;
+          }
+          pending.append(record.text_, record.length_);
+          if (!record.continued_) {
+            pending.push_back('\n');
+            ++expected;
+          }
+          buffer->head_.store(++head, std::memory_order_release);
+          progress = true;
+        }
+      }
+      if (pending.size() >= flush_threshold_ || (!progress && !pending.empty())) {
+        out_.write(pending.data(), pending.size());
+        out_.flush();
+        pending.clear();
+      }
+      if (progress) {
+        idle_rounds = 0;
+        continue;
+      }
+      const bool all_written = expected == next_sequence_.load();
+      if (all_written && stopped_.load()) {
+        return;
+      }
+      // A taken sequence number that is not written yet is a record being copied
+      // (or waiting for space): it comes soon, don't fall asleep.
+      if (!all_written || ++idle_rounds < kIdleRounds) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(writer_mtx_);
+      writer_sleeping_.store(true);
+      writer_cv_.wait(lock, [this, expected] {
+        return next_sequence_.load() != expected || stopped_.load();
+      });
+      writer_sleeping_.store(false, std::memory_order_relaxed);
+      idle_rounds = 0;
+    }
+  }
+
+  std::ostream& out_;
+  const size_t buffer_capacity_;
+  const size_t flush_threshold_;
+  const uint64_t id_;
+  std::atomic<Buffer*> buffers_{nullptr};
+  alignas(64) std::atomic<uint64_t> next_sequence_{0};
+  alignas(64) std::atomic<bool> writer_sleeping_{false};
+  std::atomic<bool> stopped_{false};
+  std::mutex writer_mtx_;
+  std::condition_variable writer_cv_;
+  std::thread writer_;
+};
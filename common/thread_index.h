@@ -0,0 +1,78 @@
+//
+//  thread_index.h
+//  Common
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Small dense index of the calling thread, one per process: indices of
+// exited threads are reused, so a process that keeps creating threads
+// (e.g. an elastic pool) still gets indices below the peak number of live
+// threads. Two live threads never share an index.
+//
+// The registry never fails. A structure that keeps state per index for up
+// to max_threads threads must accept the calling thread's index being
+// max_threads or larger, and runs the operations of such threads on
+// a lock-protected path instead of failing (FlatCombining, WaitFreeQueue).
+// Where the per-index state is only there to spread contention and may be
+// shared safely, the index is folded into range instead (ShardedCounter).
+class ThreadIndexRegistry {
+ public:
+  static ThreadIndexRegistry& Instance() {
+    // Leaked on purpose: thread-local holders release their indices
+    // during thread exit, possibly after static destructors have run.
+    static ThreadIndexRegistry* registry = new ThreadIndexRegistry();
+    return *registry;
+  }
+
+  static size_t Current() {
+    thread_local Holder holder;
+    return holder.index_;
+  }
+
+  // Exclusive upper bound of the indices handed out so far.
+  size_t Bound() const {
+    return bound_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Holder {
+    Holder() : index_(Instance().Acquire()) {}
+
+    ~Holder() {
+      Instance().Release(index_);
+    }
+
+    size_t index_;
+  };
+
+  size_t Acquire() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      const size_t index = free_.back();
+      free_.pop_back();
+      return index;
+    }
+    const size_t index = bound_.load(std::memory_order_relaxed);
+    bound_.store(index + 1, std::memory_order_release);
+    return index;
+  }
+
+  void Release(const size_t index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    free_.push_back(index);
+  }
+
+  std::mutex mutex_;
+  std::vector<size_t> free_;
+  std::atomic<size_t> bound_{0};
+};
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,194 @@
+//
+//  flat_combining.h
+//  Flat_combining
+//
+
+#pragma once
+
+#include "../common/cpu_relax.h"
+#include "../common/thread_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Flat combining (Hendler, Incze, Shavit, Tzafrir): turns a sequential
+// object into a linearizable concurrent one.
+//
+// A thread publishes its operation in its own slot and then either waits
+// until someone applies it, or takes the combiner lock and applies all
+// published operations in one pass. Under contention one thread runs
+// a whole batch on a cache-hot object while the others spin on their own
+// slots, instead of every operation dragging the object and the lock
+// between cores as with a plain mutex.
+//
+// Slots are indexed by ThreadIndexRegistry (common/thread_index.h); threads
+// with an index beyond max_threads skip publication and run their operations
+// under the combiner lock directly. Operations must not call back into the same object.
+//
+// usage:
+// FlatCombining<std::deque<int>> queue;
+// queue.Apply([](std::deque<int>& deque) { deque.push_back(1); });
+// std::optional<int> front = queue.Apply([](std::deque<int>& deque) -> std::optional<int> {
+//   ...
+// });
+template <class Seq>
+class FlatCombining {
+ public:
+  static const size_t kDefaultMaxThreads = 128;
+
+  FlatCombining() : FlatCombining(Seq()) {}
+
+  explicit FlatCombining(Seq object, const size_t max_threads = kDefaultMaxThreads)
+      : slots_(max_threads),
+        object_(std::move(object)) {}
+
+  FlatCombining(const FlatCombining&) = delete;
+  FlatCombining& operator=(const FlatCombining&) = delete;
+
+  // Runs operation(object) atomically w.r.t. all other operations
+  // and returns its result. An exception thrown by the operation
+  // is rethrown in the calling thread.
+  template <class Operation>
+  auto Apply(Operation operation) -> decltype(operation(std::declval<Seq&>())) {
+    using Result = decltype(operation(std::declval<Seq&>()));
+    Request<Operation, Result> request(operation);
+
+    const size_t index = ThreadIndexRegistry::Current();
+    if (index >= slots_.size()) {
+      LockCombiner();
+      request.Run(object_);
+      UnlockCombiner();
+      return request.Take();
+    }
+
+    Slot& slot = slots_[index];
+    slot.request_ = &request;
+    slot.run_.store(&Request<Operation, Result>::Trampoline, std::memory_order_release);
+
+    for (size_t spins = 0; slot.run_.load(std::memory_order_acquire) != nullptr; ++spins) {
+      if (!combiner_locked_.load(std::memory_order_relaxed) && TryLockCombiner()) {
+        Combine();
+        UnlockCombiner();
+        // Our own slot was served by the pass above.
+        break;
+      }
+      Backoff(spins);
+    }
+    return request.Take();
+  }
+
+  // Access to the sequential object without synchronization,
+  // e.g. to fill it before the threads start or to inspect it after they finish.
+  Seq& Unsafe() {
+    return object_;
+  }
+
+ private:
+  using Trampoline = void (*)(Seq&, void*);
+
+  // Lives on the stack of the publishing thread until the operation is done.
+  template <class Operation, class Result>
+  struct Request {
+    explicit Request(Operation& operation) : operation_(operation) {}
+
+    Operation& operation_;
+    std::conditional_t<std::is_void<Result>::value, bool, std::optional<Result>> result_{};
+    std::exception_ptr error_;
+
+    void Run(Seq& object) {
+      try {
+        if constexpr (std::is_void<Result>::value) {
+          operation_(object);
+        } else {
+          result_.emplace(operation_(object));
+        }
+      } catch (...) {
+        error_ = std::current_exception();
+      }
+    }
+
+    Result Take() {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      if constexpr (!std::is_void<Result>::value) {
+        return std::move(*result_);
+      }
+    }
+
+    static void Trampoline(Seq& object, void* request) {
+      static_cast<Request*>(request)->Run(object);
+    }
+  };
+
+  // Own cache lines, so that publishing and waiting touch nothing shared.
+  struct alignas(64) Slot {
+    // Non-null while an operation is published and not yet applied;
+    // request_ is written before the release store of run_.
+    std::atomic<Trampoline> run_{nullptr};
+    void* request_{nullptr};
+  };
+
+  // Several passes, so that threads which publish right after the combiner
+  // has passed their slots still get served in this batch.
+  static const size_t kCombinePasses = 3;
+
+  void Combine() {
+    const size_t bound = std::min(ThreadIndexRegistry::Instance().Bound(), slots_.size());
+    for (size_t pass = 0; pass < kCombinePasses; ++pass) {
+      size_t applied = 0;
+      for (size_t i = 0; i < bound; ++i) {
+        Slot& slot = slots_[i];
+        const Trampoline run = slot.run_.load(std::memory_order_acquire);
+        if (run == nullptr) {
+          continue;
+        }
+        run(object_, slot.request_);
+        slot.run_.store(nullptr, std::memory_order_release);
+        ++applied;
+      }
+      if (applied == 0) {
+        break;
+      }
+    }
+  }
+
+  bool TryLockCombiner() {
+    return !combiner_locked_.exchange(true, std::memory_order_acquire);
+  }
+
+  void LockCombiner() {
+    for (size_t spins = 0; combiner_locked_.load(std::memory_order_relaxed) || !TryLockCombiner(); ++spins) {
+      Backoff(spins);
+    }
+  }
+
+  void UnlockCombiner() {
+    combiner_locked_.store(false, std::memory_order_release);
+  }
+
+  // Spins briefly, then yields: a combiner that has been preempted
+  // should get its CPU back rather than be spun against.
+  static void Backoff(const size_t spins) {
+    if (spins < 64) {
+      CpuRelax();
+    } else {
+      std::this_thread::yield();
+    }
+  }
+
+  std::vector<Slot> slots_;
+  alignas(64) std::atomic<bool> combiner_locked_{false};
+  alignas(64) Seq object_;
+};
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,374 @@
+//
+//  contention_profiler.h
+//  Contention_profiler
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////
+
+// Cheap timestamp in "ticks": TSC cycles on x86, nanoseconds elsewhere.
+inline uint64_t ReadTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Aggregated statistics of one lock instance.
+struct LockContention {
+  std::string name;
+  uint64_t acquisitions = 0;
+  uint64_t wait_ticks = 0;
+  uint64_t max_wait_ticks = 0;
+  uint64_t hold_ticks = 0;
+};
+
+// Process-wide collector of lock statistics.
+// Every acquisition becomes an event in the buffer of the thread that made it;
+// a buffer is merged into the totals when it fills up, when its thread exits,
+// or when the thread calls Flush(). So Report() sees all events of finished
+// threads and of the calling one, and the locks themselves share nothing
+// but their own state.
+class ContentionProfiler {
+ public:
+  static ContentionProfiler& Instance() {
+    // Leaked on purpose: thread-local buffers flush into it during thread exit,
+    // which may happen after static destructors have run.
+    static ContentionProfiler* profiler = new ContentionProfiler();
+    return *profiler;
+  }
+
+  // Locks registered while a NamingScope is alive get names "<prefix> #<n>",
+  // where n counts the registrations inside the scope. E.g. the stripes of
+  // a hash set built inside NamingScope("stripe") are named by their indices.
+  class NamingScope {
+   public:
+    explicit NamingScope(std::string prefix) : previous_(CurrentScope()), prefix_(std::move(prefix)) {
+      CurrentScope() = this;
+    }
+
+    ~NamingScope() {
+      CurrentScope() = previous_;
+    }
+
+    NamingScope(const NamingScope&) = delete;
+    NamingScope& operator=(const NamingScope&) = delete;
+
+   private:
+    friend class ContentionProfiler;
+
+    NamingScope* previous_;
+    std::string prefix_;
+    size_t registered_{0};
+  };
+
+  size_t Register() {
+    const size_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+    NamingScope* scope = CurrentScope();
+    if (scope != nullptr) {
+      SetName(id, scope->prefix_ + " #" + std::to_string(scope->registered_++));
+    }
+    return id;
+  }
+
+  void SetName(const size_t id, std::string name) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    totals_[id].name = std::move(name);
+  }
+
+  void Record(const size_t id, const uint64_t wait_ticks, const uint64_t hold_ticks) {
+    LocalBuffer().Push({id, wait_ticks, hold_ticks});
+  }
+
+  // Publishes the events of the calling thread.
+  void Flush() {
+    LocalBuffer().Flush();
+  }
+
+  // Locks sorted by total wait time, the most contended first.
+  std::vector<LockContention> Report() {
+    Flush();
+    std::vector<LockContention> report;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      for (const auto& entry: totals_) {
+        if (entry.second.acquisitions == 0) {
+          continue;
+        }
+        report.push_back(entry.second);
+        if (report.back().name.empty()) {
+          report.back().name = "lock #" + std::to_string(entry.first);
+        }
+      }
+    }
+    std::sort(report.begin(), report.end(), [](const LockContention& lhs, const LockContention& rhs) {
+      return lhs.wait_ticks > rhs.wait_ticks;
+    });
+    return report;
+  }
+
+  void PrintReport(std::ostream& out, const size_t top = 20) {
+    const std::vector<LockContention> report = Report();
+    uint64_t total_wait = 0;
+    for (const LockContention& lock: report) {
+      total_wait += lock.wait_ticks;
+    }
+    const double ns_per_tick = NanosecondsPerTick();
+    out << std::left << std::setw(24) << "lock"
+        << std::right << std::setw(12) << "acquired"
+        << std::setw(14) << "avg wait ns"
+        << std::setw(14) << "max wait ns"
+        << std::setw(14) << "avg hold ns"
+        << std::setw(10) << "wait %" << "\n";
+    for (size_t i = 0; i < report.size() && i < top; ++i) {
+      const LockContention& lock = report[i];
+      out << std::left << std::setw(24) << lock.name
+          << std::right << std::setw(12) << lock.acquisitions
+          << std::fixed << std::setprecision(1)
+          << std::setw(14) << lock.wait_ticks * ns_per_tick / lock.acquisitions
+          << std::setw(14) << lock.max_wait_ticks * ns_per_tick
+          << std::setw(14) << lock.hold_ticks * ns_per_tick / lock.acquisitions
+          << std::setw(10) << (total_wait == 0 ? 0.0 : 100.0 * lock.wait_ticks / total_wait) << "\n";
+    }
+  }
+
+  // Drops collected statistics, keeps the names.
+  void Reset() {
+    Flush();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& entry: totals_) {
+      entry.second = LockContention{std::move(entry.second.name)};
+    }
+  }
+
+  // Measured once against steady_clock.
+  static double NanosecondsPerTick() {
+    static const double ns_per_tick = [] {
+      const auto start_time = std::chrono::steady_clock::now();
+      const uint64_t start_ticks = ReadTicks();
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      const uint64_t ticks = ReadTicks() - start_ticks;
+      const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start_time).count();
+      return ticks == 0 ? 1.0 : ns / ticks;
+    }();
+    return ns_per_tick;
+  }
+
+ private:
+  struct Event {
+    size_t lock_id_;
+    uint64_t wait_ticks_;
+    uint64_t hold_ticks_;
+  };
+
+  class ThreadBuffer {
+   public:
+    static const size_t kCapacity = 4096;
+
+    ThreadBuffer() {
+      events_.reserve(kCapacity);
+    }
+
+    ~ThreadBuffer() {
+      Flush();
+    }
+
+    void Push(const Event& event) {
+      events_.push_back(event);
+      if (events_.size() == kCapacity) {
+        Flush();
+      }
+    }
+
+    void Flush() {
+      if (!events_.empty()) {
+        Instance().Merge(events_);
+        events_.clear();
+      }
+    }
+
+   private:
+    std::vector<Event> events_;
+  };
+
+  ContentionProfiler() = default;
+
+  static ThreadBuffer& LocalBuffer() {
+    thread_local ThreadBuffer buffer;
+    return buffer;
+  }
+
+  static NamingScope*& CurrentScope() {
+    thread_local NamingScope* scope = nullptr;
+    return scope;
+  }
+
+  void Merge(const std::vector<Event>& events) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const Event& event: events) {
+      LockContention& totals = totals_[event.lock_id_];
+      ++totals.acquisitions;
+      totals.wait_ticks += event.wait_ticks_;
+      totals.max_wait_ticks = std::max(totals.max_wait_ticks, event.wait_ticks_);
+      totals.hold_ticks += event.hold_ticks_;
+    }
+  }
+
+  std::atomic<size_t> next_id_{0};
+  std::mutex mutex_;
+  std::unordered_map<size_t, LockContention> totals_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Drop-in replacement for any lock of the repo that records its acquisitions
+// into ContentionProfiler. Wraps whichever interface the lock has:
+// - lock()/unlock()/try_lock(), with arguments if needed
+//   (std::mutex, the writer side of RWlock, TreeMutex::lock(thread_index));
+// - lock_shared()/unlock_shared() (the reader side of RWlock);
+// - Lock()/Unlock() (SpinLock of the optimistic list);
+// - Guard (MCSSpinLock and the other queue locks with a Guard).
+// Only the members that are actually used get instantiated.
+//
+// usage:
+// StripedHashSet<int, std::hash<int>, ProfiledLock<std::mutex>> set(16);
+// ...
+// ContentionProfiler::Instance().PrintReport(std::cout);
+template <class Mutex>
+class ProfiledLock {
+ public:
+  class Guard {
+   public:
+    explicit Guard(ProfiledLock& profiled)
+        : profiled_(profiled),
+          start_(ReadTicks()),
+          guard_(profiled.lock_) {
+      profiled_.Acquired(start_);
+    }
+
+    // The inner guard releases the lock after this body.
+    ~Guard() {
+      profiled_.Released();
+    }
+
+   private:
+    ProfiledLock& profiled_;
+    uint64_t start_;
+    typename Mutex::Guard guard_;
+  };
+
+  template <class... Args>
+  explicit ProfiledLock(Args&&... args)
+      : lock_(std::forward<Args>(args)...),
+        id_(ContentionProfiler::Instance().Register()) {}
+
+  ProfiledLock(const ProfiledLock&) = delete;
+  ProfiledLock& operator=(const ProfiledLock&) = delete;
+
+  void SetName(std::string name) {
+    ContentionProfiler::Instance().SetName(id_, std::move(name));
+  }
+
+  template <class... Args>
+  void lock(Args... args) {
+    const uint64_t start = ReadTicks();
+    lock_.lock(args...);
+    Acquired(start);
+  }
+
+  template <class... Args>
+  bool try_lock(Args... args) {
+    const uint64_t start = ReadTicks();
+    if (!lock_.try_lock(args...)) {
+      return false;
+    }
+    Acquired(start);
+    return true;
+  }
+
+  template <class... Args>
+  void unlock(Args... args) {
+    Released();
+    lock_.unlock(args...);
+  }
+
+  void Lock() {
+    const uint64_t start = ReadTicks();
+    lock_.Lock();
+    Acquired(start);
+  }
+
+  void Unlock() {
+    Released();
+    lock_.Unlock();
+  }
+
+  // Several readers hold the lock at once, so their acquisition times
+  // are kept by the readers themselves.
+  void lock_shared() {
+    const uint64_t start = ReadTicks();
+    lock_.lock_shared();
+    const uint64_t acquired = ReadTicks();
+    SharedHolds().push_back({this, {acquired - start, acquired}});
+  }
+
+  void unlock_shared() {
+    std::vector<SharedHold>& holds = SharedHolds();
+    auto hold = std::find_if(holds.rbegin(), holds.rend(),
+                             [this](const SharedHold& hold) { return hold.first == this; });
+    if (hold != holds.rend()) {
+      ContentionProfiler::Instance().Record(id_, hold->second.first, ReadTicks() - hold->second.second);
+      holds.erase(std::next(hold).base());
+    }
+    lock_.unlock_shared();
+  }
+
+ private:
+  // (lock, (wait ticks, acquisition timestamp))
+  using SharedHold = std::pair<const void*, std::pair<uint64_t, uint64_t>>;
+
+  static std::vector<SharedHold>& SharedHolds() {
+    thread_local std::vector<SharedHold> holds;
+    return holds;
+  }
+
+  // Both are called by the owner only.
+  void Acquired(const uint64_t start) {
+    acquired_at_ = ReadTicks();
+    wait_ticks_ = acquired_at_ - start;
+  }
+
+  void Released() {
+    ContentionProfiler::Instance().Record(id_, wait_ticks_, ReadTicks() - acquired_at_);
+  }
+
+  Mutex lock_;
+  const size_t id_;
+  uint64_t acquired_at_{0};
+  uint64_t wait_ticks_{0};
+};
+
+///////////////////////////////////////////////////////////////////////
@@ -110,3 +110,95 @@ private:
     std::atomic<size_t> locked_thread_;
 };
 
+
+
+// Peterson mutex occupying its own cache line, so that siblings in the tree
+// spinning on neighbouring nodes don't invalidate each other's lines.
+// The exchange on victim_ orders our want_ store before the load of the other's want_,
+// so the rest of the accesses can be acquire/release instead of seq_cst.
+class alignas(64) PaddedPetersonMutex {
+public:
+    void lock(int thread_id) {
+        want_[thread_id].store(true, std::memory_order_relaxed);
+        victim_.exchange(thread_id, std::memory_order_acq_rel);
+        while (want_[1 - thread_id].load(std::memory_order_acquire) &&
+               victim_.load(std::memory_order_relaxed) == thread_id) {
+            std::this_thread::yield();
+        }
+    }
+    
+    void unlock(int thread_id) {
+        want_[thread_id].store(false, std::memory_order_release);
+    }
+    
+private:
+    std::array<std::atomic<bool>, 2> want_{{{false}, {false}}};
+    std::atomic<int> victim_{0};
+};
+
+// Tournament tree mutex with a fast path.
+// The lock itself is the locked_ flag. If nobody is climbing the tree,
+// a thread takes the flag with one CAS and doesn't touch the tree at all.
+// Otherwise it climbs the tree as in TreeMutex, and only the winner of the root
+// competes for the flag (with at most one fast-path owner).
+// Fast path is not taken while someone is climbing, so climbing threads are not starved.
+// Thread ids still have to be less than n_threads.
+class FastPathTreeMutex {
+public:
+    explicit FastPathTreeMutex(size_t n_threads)
+        : leafs_num_(Pow(2, Log2(n_threads))),
+          height_(Log2(leafs_num_)),
+          peterson_mtx_(leafs_num_ - 1) {}
+    
+    void lock(size_t current_thread) {
+        if (climbing_threads_.load(std::memory_order_relaxed) == 0 && TryLockFlag()) {
+            owner_climbed_ = false;
+            return;
+        }
+        climbing_threads_.fetch_add(1, std::memory_order_relaxed);
+        size_t node = leafs_num_ - 1 + current_thread;
+        for (size_t level = 0; level < height_; ++level) {
+            size_t mtx = (node - 1) / 2;
+            bool peterson_mtx_th_id = node % 2;
+            peterson_mtx_[mtx].lock(peterson_mtx_th_id);
+            node = mtx;
+        }
+        while (!TryLockFlag()) {
+            std::this_thread::yield();
+        }
+        climbing_threads_.fetch_sub(1, std::memory_order_relaxed);
+        owner_climbed_ = true;
+    }
+    
+    // The path is released from the root as in TreeMutex::unlock.
+    void unlock(size_t current_thread) {
+        if (owner_climbed_) {
+            size_t mtx = 0;
+            for (int level = height_ - 1; level >= 0; --level) {
+                int digit = ((current_thread & (1 << level)) == 0) ? 0 : 1;
+                bool peterson_mtx_th_id = 1 - digit;
+                peterson_mtx_[mtx].unlock(peterson_mtx_th_id);
+                mtx = mtx * 2 + 1 + digit;
+            }
+        }
+        locked_.store(false, std::memory_order_release);
+    }
+    
+    FastPathTreeMutex(const FastPathTreeMutex&) = delete;
+    FastPathTreeMutex& operator=(const FastPathTreeMutex&) = delete;
+    
+private:
+    bool TryLockFlag() {
+        bool expected = false;
+        return locked_.compare_exchange_strong(expected, true, std::memory_order_acquire,
+                                               std::memory_order_relaxed);
+    }
+    
+    size_t leafs_num_;
+    size_t height_;
+    std::vector<PaddedPetersonMutex> peterson_mtx_;
+    std::atomic<bool> locked_{false};
+    std::atomic<size_t> climbing_threads_{0};
+    // Written and read by the owner only.
+    bool owner_climbed_{false};
+};
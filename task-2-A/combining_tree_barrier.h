@@ -0,0 +1,131 @@
+//
+//  combining_tree_barrier.h
+//  Cyclic_barrier
+//
+
+#pragma once
+
+#include "../common/cpu_relax.h"
+#include "../common/futex.h"
+
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+// Cyclic barrier for many threads.
+// Arrival goes through a combining tree: every node counts at most fan_in arrivals,
+// and only the last thread arriving at a node goes up to its parent, so no cache line
+// is shared by more than fan_in threads. The thread completing the root releases
+// everybody by flipping the global sense (sense reversal makes the barrier reusable
+// without resetting anything else). Waiters spin on the sense for a while
+// and then sleep on a futex; the releaser calls the kernel only if somebody sleeps.
+// Like TreeMutex, it needs thread ids: 0 <= thread_id < num_threads.
+class CombiningTreeBarrier {
+ public:
+  static constexpr size_t kDefaultFanIn = 4;
+  static constexpr size_t kDefaultSpinBudget = 4096;
+
+  explicit CombiningTreeBarrier(size_t num_threads,
+                                size_t fan_in = kDefaultFanIn,
+                                size_t spin_budget = kDefaultSpinBudget)
+      : fan_in_(fan_in < 2 ? 2 : fan_in),
+        spin_budget_(spin_budget),
+        thread_senses_(num_threads) {
+    BuildTree(num_threads);
+  }
+  
+  // Thread waits untill all other threads call this method too.
+  void Pass(size_t thread_id) {
+    const int my_sense = thread_senses_[thread_id].sense_ ^= 1;
+    size_t node = thread_id / fan_in_;
+    while (true) {
+      Node& current = nodes_[node];
+      if (current.arrived_.fetch_add(1, std::memory_order_acq_rel) + 1 < current.expected_) {
+        Wait(my_sense);
+        return;
+      }
+      // We are the last one here, so nobody else touches this node until the release.
+      current.arrived_.store(0, std::memory_order_relaxed);
+      if (current.parent_ == kNoParent) {
+        Release(my_sense);
+        return;
+      }
+      node = current.parent_;
+    }
+  }
+  
+  CombiningTreeBarrier(const CombiningTreeBarrier&) = delete;
+  CombiningTreeBarrier& operator=(const CombiningTreeBarrier&) = delete;
+  
+ private:
+  static constexpr size_t kNoParent = static_cast<size_t>(-1);
+  
+  struct alignas(64) Node {
+    std::atomic<size_t> arrived_{0};
+    size_t expected_{0};
+    size_t parent_{kNoParent};
+  };
+  
+  // Sense of the phase the thread is passing now, touched by its owner only.
+  struct alignas(64) ThreadSense {
+    int sense_{0};
+  };
+  
+  // Level by level: level 0 has one node per fan_in threads,
+  // every next level has one node per fan_in nodes of the previous one.
+  void BuildTree(size_t num_threads) {
+    std::vector<size_t> expected;
+    std::vector<size_t> parents;
+    size_t level_begin = 0;
+    size_t width = num_threads == 0 ? 1 : num_threads;
+    while (true) {
+      const size_t level_size = (width + fan_in_ - 1) / fan_in_;
+      const size_t next_level_begin = level_begin + level_size;
+      for (size_t i = 0; i < level_size; ++i) {
+        expected.push_back(i + 1 < level_size ? fan_in_ : width - i * fan_in_);
+        parents.push_back(level_size == 1 ? kNoParent : next_level_begin + i / fan_in_);
+      }
+      if (level_size == 1) {
+        break;
+      }
+      level_begin = next_level_begin;
+      width = level_size;
+    }
+    nodes_ = std::vector<Node>(expected.size());
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      nodes_[i].expected_ = expected[i];
+      nodes_[i].parent_ = parents[i];
+    }
+  }
+  
+  void Wait(int my_sense) {
+    for (size_t i = 0; i < spin_budget_; ++i) {
+      if (sense_.load(std::memory_order_acquire) == my_sense) {
+        return;
+      }
+      CpuRelax();
+    }
+    // sleepers_ and sense_ are seq_cst: either the releaser sees us sleeping,
+    // or we see the new sense before going to sleep.
+    sleepers_.fetch_add(1);
+    while (sense_.load() != my_sense) {
+      FutexWait(&sense_, my_sense ^ 1);
+    }
+    sleepers_.fetch_sub(1);
+  }
+  
+  void Release(int my_sense) {
+    sense_.store(my_sense);
+    if (sleepers_.load() > 0) {
+      FutexWake(&sense_, INT_MAX);
+    }
+  }
+  
+  const size_t fan_in_;
+  const size_t spin_budget_;
+  std::vector<Node> nodes_;
+  std::vector<ThreadSense> thread_senses_;
+  alignas(64) std::atomic<int> sense_{0};
+  alignas(64) std::atomic<size_t> sleepers_{0};
+};
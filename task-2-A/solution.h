@@ -9,33 +9,76 @@
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
+#include <utility>
 #include <vector>
 
+// Default completion function of CyclicBarrier: does nothing.
+struct NoCompletion {
+  void operator()() const {}
+};
+
 // Implementation of cyclic barrier class.
-template <class ConditionVariable = std::condition_variable>
+// CompletionFunction is called by the last arriving thread of every phase,
+// exactly once per phase and before any waiting thread is released.
+template <class ConditionVariable = std::condition_variable,
+          class CompletionFunction = NoCompletion>
 class CyclicBarrier {
  public:
-  explicit CyclicBarrier(size_t num_threads)
+  // Returned by Arrive() and identifies the epoche the thread has arrived at.
+  class PhaseToken {
+   private:
+    explicit PhaseToken(int epoche) : epoche_(epoche) {}
+    
+    int epoche_;
+    
+    friend class CyclicBarrier;
+  };
+  
+  explicit CyclicBarrier(size_t num_threads,
+                         CompletionFunction on_completion = CompletionFunction())
       : n_threads_(num_threads),
         counter_of_waiting_threads_(2),
-        current_epoche_(0) {}
+        current_epoche_(0),
+        on_completion_(std::move(on_completion)) {}
   
   // If thread calls this method, it will wait untill all other threads call
   // this method too and only then this thread (as well as others) will continue.
   void Pass() {
+    Wait(Arrive());
+  }
+  
+  // Split-phase version of Pass(): Arrive() registers the thread in the current epoche
+  // and returns immediately, so the thread can do independent work before Wait(token).
+  // A thread has to call Wait (or know the epoche is over) before arriving again,
+  // because the counter of an epoche is reused two epoches later.
+  PhaseToken Arrive() {
     const int my = current_epoche_.load();
-    if (counter_of_waiting_threads_[my].fetch_add(1) < n_threads_ - 1) {
-      std::unique_lock<std::mutex> lock(mtx_);
-      // Condition in cond_var_.wait args protects from spurious wakeups.
-      all_threads_arrived_cv_.wait(lock, [this, &my](){ return counter_of_waiting_threads_[my].load() == n_threads_; });
-    } else {
-      // Switch the current epoche over to the next:
-      // XOR for current_epoche_ variable, e.g. if current epoche has number 1,
-      // the next epoche will have number 0.
-      current_epoche_.store(current_epoche_.load() ^ 1);
-      counter_of_waiting_threads_[current_epoche_.load()].store(0);
+    if (counter_of_waiting_threads_[my].fetch_add(1) == n_threads_ - 1) {
+      on_completion_();
+      // The counter of the next epoche is reset before the switch,
+      // so that nobody can arrive at the next epoche before the reset.
+      counter_of_waiting_threads_[my ^ 1].store(0);
+      {
+        // Switching under the mutex prevents a lost wakeup between
+        // the check of the condition in Wait and falling asleep.
+        std::unique_lock<std::mutex> lock(mtx_);
+        // XOR for current_epoche_ variable, e.g. if current epoche has number 1,
+        // the next epoche will have number 0.
+        current_epoche_.store(my ^ 1);
+      }
       all_threads_arrived_cv_.notify_all();
     }
+    return PhaseToken(my);
+  }
+  
+  // Waits untill the epoche of the token is over.
+  void Wait(PhaseToken token) {
+    if (current_epoche_.load() != token.epoche_) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mtx_);
+    // Condition in cond_var_.wait args protects from spurious wakeups.
+    all_threads_arrived_cv_.wait(lock, [this, &token](){ return current_epoche_.load() != token.epoche_; });
   }
   
   CyclicBarrier(const CyclicBarrier&) = delete;
@@ -45,6 +88,7 @@ class CyclicBarrier {
   size_t n_threads_;
   std::vector<std::atomic<size_t>> counter_of_waiting_threads_;
   std::atomic<int> current_epoche_;
+  CompletionFunction on_completion_;
   ConditionVariable all_threads_arrived_cv_;
   std::mutex mtx_;
 };
@@ -6,56 +6,29 @@
 //  Copyright (c) 2017 Igashov_Ilya. All rights reserved.
 //
 
-#include <atomic>
-#include <condition_variable>
-#include <iostream>
-#include <mutex>
-#include <vector>
+#include "../common/step_log_sink.h"
+#include "token_ring.h"
 
-// Implementation of semaphore.
-class Semaphore {
- public:
-  Semaphore() : signals_counter_(0) {}
-  
-  void wait() {
-    std::unique_lock<std::mutex> lock(mtx_);
-    if (signals_counter_ == 0) {
-      get_signal_cv_.wait(lock, [this](){ return signals_counter_ > 0;});
-    }
-    --signals_counter_;
-  }
-  
-  void signal() {
-    std::unique_lock<std::mutex> lock(mtx_);
-    ++signals_counter_;
-    get_signal_cv_.notify_one();
-  }
-  
- private:
-  size_t signals_counter_;
-  std::condition_variable get_signal_cv_;
-  std::mutex mtx_;
-};
+#include <cstddef>
+#include <string>
 
-// Implementation of Robot-centipede using semaphores.
+// Implementation of Robot-centipede using the token ring.
 class Robot {
  public:
   explicit Robot(const std::size_t num_foots)
-      : semaphores_(num_foots) {
-          semaphores_[0].signal();
-      }
+      : ring_(num_foots) {}
   
-  // At start all legs are waiting for signal.
-  // In the constructor one signal was sent to the first leg,
+  // The token starts at the first leg,
   // so the first leg begins:
-  // it steps and signals the next one that it can step.
+  // it steps and passes the token to the next one.
   // And so on.
   void Step(const std::size_t foot) {
-    semaphores_[foot].wait();
-    std::cout << "foot " << foot << std::endl;
-    semaphores_[(foot + 1) % semaphores_.size()].signal();
+    ring_.Acquire(foot);
+    log_.Log("foot " + std::to_string(foot));
+    ring_.Release(foot);
   }
   
  private:
-  std::vector<Semaphore> semaphores_;
+  TokenRing ring_;
+  StepLogSink log_;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+//
+//  token_ring.h
+//  Robot_centipede
+//
+
+#pragma once
+
+#include "../common/cpu_relax.h"
+#include "../common/futex.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+// Strict round-robin ordering of a fixed set of participants:
+// participant i may proceed only after participant i - 1 (modulo the ring size).
+// The token is a single monotonic turn counter on its own cache line,
+// and the current holder is turn % num_participants.
+// A participant close to the token (the holder is its predecessor) spins on the counter
+// for a while; others sleep on their own futex slots right away. On release the holder wakes up
+// the new holder and the one after it, so the latter is already spinning
+// by the time the token comes.
+// Every participant must be driven by one thread at a time.
+//
+// usage:
+// ring.Acquire(i);
+// ... // i's turn
+// ring.Release(i);
+//
+class TokenRing {
+ public:
+  explicit TokenRing(const size_t num_participants)
+      : slots_(num_participants == 0 ? 1 : num_participants) {}
+  
+  // Waits untill it is participant's turn.
+  void Acquire(const size_t participant) {
+    size_t spins = 0;
+    while (true) {
+      const size_t distance = Distance(participant);
+      if (distance == 0) {
+        return;
+      }
+      if (distance <= kSpinDistance && spins < kSpinBudget) {
+        ++spins;
+        CpuRelax();
+      } else {
+        Park(participant);
+        spins = 0;
+      }
+    }
+  }
+  
+  // Passes the token to the next participant. Must be called by the holder.
+  void Release(const size_t participant) {
+    turn_.store(turn_.load(std::memory_order_relaxed) + 1);
+    Wake((participant + 1) % slots_.size());
+    if (slots_.size() > 2) {
+      Wake((participant + 2) % slots_.size());
+    }
+  }
+  
+  TokenRing(const TokenRing&) = delete;
+  TokenRing& operator=(const TokenRing&) = delete;
+  
+ private:
+  static constexpr size_t kSpinDistance = 1;
+  // Even a near participant stops spinning eventually: the holder may be preempted.
+  static constexpr size_t kSpinBudget = 1024;
+  
+  struct alignas(64) Slot {
+    std::atomic<int> wake_sequence_{0};
+    std::atomic<bool> sleeping_{false};
+  };
+  
+  // How many releases have to happen before it is participant's turn.
+  size_t Distance(const size_t participant) const {
+    const size_t holder = turn_.load() % slots_.size();
+    return (participant + slots_.size() - holder) % slots_.size();
+  }
+  
+  // sleeping_ and turn_ are seq_cst: either the releaser sees us sleeping,
+  // or we see the new turn and don't fall asleep.
+  // If a wakeup comes between reading wake_sequence_ and FutexWait, the latter returns at once.
+  void Park(const size_t participant) {
+    Slot& slot = slots_[participant];
+    const int sequence = slot.wake_sequence_.load(std::memory_order_acquire);
+    slot.sleeping_.store(true);
+    if (Distance(participant) != 0) {
+      FutexWait(&slot.wake_sequence_, sequence);
+    }
+    slot.sleeping_.store(false, std::memory_order_relaxed);
+  }
+  
+  void Wake(const size_t participant) {
+    Slot& slot = slots_[participant];
+    if (slot.sleeping_.load()) {
+      slot.wake_sequence_.fetch_add(1, std::memory_order_release);
+      FutexWake(&slot.wake_sequence_, 1);
+    }
+  }
+  
+  alignas(64) std::atomic<size_t> turn_{0};
+  std::vector<Slot> slots_;
+};
@@ -6,8 +6,9 @@
 //  Copyright (c) 2017 Igashov_Ilya. All rights reserved.
 //
 
+#include "../common/step_log_sink.h"
+
 #include <condition_variable>
-#include <iostream>
 #include <mutex>
 
 // Implememtation of Robot using condition variables only.
@@ -17,7 +18,7 @@ class Robot {
   
   void StepLeft() {
     std::unique_lock<std::mutex> lock(mtx_);
-    std::cout << "left" << std::endl;
+    log_.Log("left");
     left_stepped_ = true;
     another_leg_stepped_.notify_one();
     another_leg_stepped_.wait(lock, [this](){ return !left_stepped_; });
@@ -27,7 +28,7 @@ class Robot {
     std::unique_lock<std::mutex> lock(mtx_);
     another_leg_stepped_.wait(lock, [this](){ return left_stepped_; });
     left_stepped_ = false;
-    std::cout << "right" << std::endl;
+    log_.Log("right");
     another_leg_stepped_.notify_one();
   }
   
@@ -35,4 +36,5 @@ class Robot {
   bool left_stepped_;
   std::condition_variable another_leg_stepped_;
   std::mutex mtx_;
+  StepLogSink log_;
 };
\ No newline at end of file
@@ -6,36 +6,81 @@
 //  Copyright (c) 2017 Igashov_Ilya. All rights reserved.
 //
 
+#include "../common/cpu_relax.h"
+#include "../common/futex.h"
+#include "../common/step_log_sink.h"
+
+#include <algorithm>
 #include <atomic>
-#include <condition_variable>
-#include <iostream>
-#include <mutex>
+#include <cstddef>
 
-// Implementation of semaphore.
+// Counting semaphore whose count lives in one atomic.
+// Positive counter is the number of available signals, negative one is
+// minus the number of threads that are sleeping (or about to sleep).
+// Uncontended Wait and Signal are a single atomic RMW on the counter; a waiter
+// spins for a while and only then sleeps on a futex. The futex word is
+// a second atomic, wakeups_, touched only when somebody sleeps: Signal grants
+// sleepers wakeups there and goes to the kernel only in that case.
 class Semaphore {
  public:
-  Semaphore(const size_t start = 0) : signals_counter_(start) {}
+  Semaphore(const size_t start = 0) : signals_counter_(static_cast<int>(start)) {}
   
   // Thread will wait untill there is at least one signal.
   void Wait() {
-    std::unique_lock<std::mutex> lock(mtx_);
-    if (signals_counter_ == 0) {
-      get_signal_cv_.wait(lock, [this](){ return signals_counter_ > 0; });
+    for (size_t i = 0; i < kSpinBudget; ++i) {
+      if (TryWait()) {
+        return;
+      }
+      CpuRelax();
+    }
+    if (signals_counter_.fetch_sub(1, std::memory_order_acquire) > 0) {
+      return;
+    }
+    // The counter is negative now, so the next Signal will hand us a wakeup.
+    while (true) {
+      int wakeups = wakeups_.load(std::memory_order_relaxed);
+      while (wakeups > 0) {
+        if (wakeups_.compare_exchange_weak(wakeups, wakeups - 1, std::memory_order_acquire,
+                                           std::memory_order_relaxed)) {
+          return;
+        }
+      }
+      FutexWait(&wakeups_, 0);
     }
-    --signals_counter_;
   }
   
-  // Sends another signal that means that signals_counter_ increments.
-  void Signal() {
-    std::unique_lock<std::mutex> lock(mtx_);
-    ++signals_counter_;
-    get_signal_cv_.notify_one();
+  // Takes a signal if there is one, never blocks.
+  bool TryWait() {
+    int signals = signals_counter_.load(std::memory_order_relaxed);
+    while (signals > 0) {
+      if (signals_counter_.compare_exchange_weak(signals, signals - 1, std::memory_order_acquire,
+                                                 std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
   }
   
+  // Sends n signals at once and wakes up as many sleeping threads as needed.
+  void Signal(const size_t n = 1) {
+    const int count = static_cast<int>(n);
+    const int old_signals = signals_counter_.fetch_add(count, std::memory_order_release);
+    const int sleeping = old_signals < 0 ? std::min(-old_signals, count) : 0;
+    if (sleeping > 0) {
+      wakeups_.fetch_add(sleeping, std::memory_order_release);
+      FutexWake(&wakeups_, sleeping);
+    }
+  }
+  
+  Semaphore(const Semaphore&) = delete;
+  Semaphore& operator=(const Semaphore&) = delete;
+  
  private:
-  size_t signals_counter_;
-  std::condition_variable get_signal_cv_;
-  std::mutex mtx_;
+  static constexpr size_t kSpinBudget = 256;
+  
+  std::atomic<int> signals_counter_;
+  // Wakeups granted by Signal to the threads that have gone to sleep.
+  std::atomic<int> wakeups_{0};
 };
 
 // Implememtation of Robot using semaphores.
@@ -43,17 +88,18 @@ class Robot {
  public:
   void StepLeft() {
     left_semaphore_.Wait();
-    std::cout << "left" << std::endl;
+    log_.Log("left");
     right_semaphore_.Signal();
   }
   
   void StepRight() {
     right_semaphore_.Wait();
-    std::cout << "right" << std::endl;
+    log_.Log("right");
     left_semaphore_.Signal();
   }
   
  private:
   Semaphore left_semaphore_{1};
   Semaphore right_semaphore_;
+  StepLogSink log_;
 };
\ No newline at end of file
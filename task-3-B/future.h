@@ -0,0 +1,414 @@
+//
+//  future.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include "pool_allocator.h"
+#include "task.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Something that runs tasks, e.g. ThreadPool.
+class Executor {
+ public:
+  virtual ~Executor() = default;
+  
+  // May throw if the executor doesn't accept tasks any more.
+  virtual void Execute(Task task) = 0;
+  
+  // Runs queued tasks on the calling thread until done() is true, and sleeps
+  // while there are none. Lets a thread that waits for a result help instead
+  // of blocking. Whoever makes done() true has to call WakeHelpers() afterwards.
+  virtual void HelpUntil(const std::function<bool()>& done) = 0;
+  
+  // Wakes up the threads sleeping in HelpUntil() to check their done() again.
+  virtual void WakeHelpers() = 0;
+  
+  // Executor whose worker the calling thread is (nullptr for other threads).
+  static Executor*& Current() {
+    static thread_local Executor* current = nullptr;
+    return current;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Value stored for Future<void>.
+struct Unit {};
+
+template <class T>
+using StoredType = typename std::conditional<std::is_void<T>::value, Unit, T>::type;
+
+// Shared state of Promise and Future: the result and the callbacks
+// waiting for it. Callbacks are either scheduled on the executor or,
+// if they are cheap (internal bookkeeping of WhenAll/WhenAny), called
+// right on the thread that fulfils the promise.
+template <class T>
+class FutureState {
+ public:
+  explicit FutureState(Executor* executor) : executor_(executor) {}
+  
+  void SetValue(StoredType<T>&& value) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (ready_) {
+      throw std::logic_error("promise already satisfied");
+    }
+    value_.emplace(std::move(value));
+    Complete(lock);
+  }
+  
+  void SetException(std::exception_ptr error) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (ready_) {
+      throw std::logic_error("promise already satisfied");
+    }
+    error_ = std::move(error);
+    Complete(lock);
+  }
+  
+  void Subscribe(Task callback, const bool run_inline) {
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (!ready_) {
+      callbacks_.push_back({std::move(callback), run_inline});
+      return;
+    }
+    lock.unlock();
+    Run({std::move(callback), run_inline});
+  }
+  
+  bool IsReady() {
+    std::unique_lock<std::mutex> lock(mtx_);
+    return ready_;
+  }
+  
+  // A worker of the executor doesn't block here: it runs other queued tasks
+  // while waiting, so fork-join code can't exhaust the pool.
+  void Wait() {
+    if (executor_ != nullptr && Executor::Current() == executor_) {
+      WaitHelping();
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mtx_);
+    ready_cv_.wait(lock, [this]() { return ready_; });
+  }
+  
+  // Runs queued tasks of the executor on the calling thread until the value is ready.
+  // The thread sleeps in the executor's queue, so both a new task and
+  // the value wake it up. HelpUntil() also returns if the executor is shut down
+  // and empty, then the value is waited for as usual.
+  void WaitHelping() {
+    if (executor_ != nullptr) {
+      executor_->HelpUntil([this]() { return IsReady(); });
+    }
+    std::unique_lock<std::mutex> lock(mtx_);
+    ready_cv_.wait(lock, [this]() { return ready_; });
+  }
+  
+  // Must be called after Wait(). Rethrows the stored exception.
+  StoredType<T> TakeValue() {
+    if (error_) {
+      std::rethrow_exception(error_);
+    }
+    return std::move(*value_);
+  }
+  
+  Executor* GetExecutor() const {
+    return executor_;
+  }
+  
+ private:
+  struct Callback {
+    Task task_;
+    bool run_inline_;
+  };
+  
+  void Complete(std::unique_lock<std::mutex>& lock) {
+    ready_ = true;
+    std::vector<Callback> callbacks = std::move(callbacks_);
+    lock.unlock();
+    ready_cv_.notify_all();
+    if (executor_ != nullptr) {
+      executor_->WakeHelpers();
+    }
+    for (Callback& callback: callbacks) {
+      Run(std::move(callback));
+    }
+  }
+  
+  // If the executor has been shut down, the callback runs on the current thread.
+  void Run(Callback callback) {
+    if (!callback.run_inline_ && executor_ != nullptr) {
+      try {
+        executor_->Execute(std::move(callback.task_));
+        return;
+      } catch (...) {
+      }
+    }
+    callback.task_();
+  }
+  
+  Executor* const executor_;
+  std::mutex mtx_;
+  std::condition_variable ready_cv_;
+  bool ready_{false};
+  std::optional<StoredType<T>> value_;
+  std::exception_ptr error_;
+  std::vector<Callback> callbacks_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+template <class T>
+class Future;
+
+template <class T>
+class Promise {
+ public:
+  explicit Promise(Executor* executor = nullptr)
+      : state_(std::allocate_shared<FutureState<T>>(PoolAllocator<FutureState<T>>(), executor)) {}
+  
+  Promise(Promise&&) = default;
+  Promise& operator=(Promise&&) = default;
+  
+  // A promise dropped without a result breaks its future instead of leaving it hanging.
+  ~Promise() {
+    if (state_ != nullptr && !state_->IsReady()) {
+      state_->SetException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+    }
+  }
+  
+  Future<T> GetFuture() {
+    return Future<T>(state_);
+  }
+  
+  template <class U = T, class = typename std::enable_if<!std::is_void<U>::value>::type>
+  void SetValue(U value) {
+    state_->SetValue(std::move(value));
+  }
+  
+  template <class U = T, class = typename std::enable_if<std::is_void<U>::value>::type>
+  void SetValue() {
+    state_->SetValue(Unit{});
+  }
+  
+  void SetException(std::exception_ptr error) {
+    state_->SetException(std::move(error));
+  }
+  
+ private:
+  std::shared_ptr<FutureState<T>> state_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Move-only future with continuations.
+// Get() and Then() consume the future.
+//
+// usage:
+// Future<int> sum = pool.Async(f).Then([](int x) { return x + 1; });
+// Future<std::vector<int>> all = WhenAll(std::move(futures));
+//
+template <class T>
+class Future {
+ public:
+  Future() = default;
+  
+  Future(Future&&) = default;
+  Future& operator=(Future&&) = default;
+  
+  Future(const Future&) = delete;
+  Future& operator=(const Future&) = delete;
+  
+  bool Valid() const {
+    return state_ != nullptr;
+  }
+  
+  bool IsReady() const {
+    return state_->IsReady();
+  }
+  
+  void Wait() const {
+    state_->Wait();
+  }
+  
+  // Like Wait(), but any thread (not only a worker) executes queued tasks meanwhile.
+  void WaitHelping() const {
+    state_->WaitHelping();
+  }
+  
+  T Get() {
+    std::shared_ptr<FutureState<T>> state = std::move(state_);
+    state->Wait();
+    if constexpr (std::is_void<T>::value) {
+      state->TakeValue();
+    } else {
+      return state->TakeValue();
+    }
+  }
+  
+  // Schedules f(value) (or f() for Future<void>) on the executor of this future
+  // once the value is ready, without blocking anybody. An exception is passed
+  // to the resulting future as is, f is not called then.
+  template <class F>
+  auto Then(F&& f) {
+    using R = decltype(Invoke(f, std::declval<StoredType<T>&&>()));
+    std::shared_ptr<FutureState<T>> state = std::move(state_);
+    Promise<R> promise(state->GetExecutor());
+    Future<R> result = promise.GetFuture();
+    state->Subscribe(
+        Task([state, f = std::forward<F>(f), promise = std::move(promise)]() mutable {
+          try {
+            if constexpr (std::is_void<R>::value) {
+              Invoke(f, state->TakeValue());
+              promise.SetValue();
+            } else {
+              promise.SetValue(Invoke(f, state->TakeValue()));
+            }
+          } catch (...) {
+            promise.SetException(std::current_exception());
+          }
+        }),
+        false);
+    return result;
+  }
+  
+ private:
+  explicit Future(std::shared_ptr<FutureState<T>> state) : state_(std::move(state)) {}
+  
+  template <class F>
+  static decltype(auto) Invoke(F& f, StoredType<T>&& value) {
+    if constexpr (std::is_void<T>::value) {
+      return f();
+    } else {
+      return f(std::move(value));
+    }
+  }
+  
+  std::shared_ptr<FutureState<T>> state_;
+  
+  friend class Promise<T>;
+  
+  template <class U>
+  friend class Future;
+  
+  template <class U>
+  friend auto WhenAll(std::vector<Future<U>> futures);
+  
+  template <class U>
+  friend auto WhenAny(std::vector<Future<U>> futures);
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Future of all values in the order of futures (Future<void> for void futures).
+// Fails with the first exception if any of the futures fails.
+template <class T>
+auto WhenAll(std::vector<Future<T>> futures) {
+  using R = typename std::conditional<std::is_void<T>::value, void, std::vector<StoredType<T>>>::type;
+  struct Context {
+    explicit Context(size_t size, Executor* executor)
+        : values_(size),
+          remaining_(size),
+          promise_(executor) {}
+    
+    std::vector<std::optional<StoredType<T>>> values_;
+    std::atomic<size_t> remaining_;
+    std::atomic<bool> failed_{false};
+    Promise<R> promise_;
+    
+    void Finish() {
+      if constexpr (std::is_void<T>::value) {
+        promise_.SetValue();
+      } else {
+        std::vector<StoredType<T>> values;
+        values.reserve(values_.size());
+        for (auto& value: values_) {
+          values.push_back(std::move(*value));
+        }
+        promise_.SetValue(std::move(values));
+      }
+    }
+  };
+  
+  Executor* executor = futures.empty() ? nullptr : futures.front().state_->GetExecutor();
+  auto context = std::make_shared<Context>(futures.size(), executor);
+  Future<R> result = context->promise_.GetFuture();
+  if (futures.empty()) {
+    context->Finish();
+    return result;
+  }
+  for (size_t i = 0; i < futures.size(); ++i) {
+    std::shared_ptr<FutureState<T>> state = std::move(futures[i].state_);
+    state->Subscribe(Task([context, state, i]() {
+      try {
+        context->values_[i].emplace(state->TakeValue());
+      } catch (...) {
+        if (!context->failed_.exchange(true)) {
+          context->promise_.SetException(std::current_exception());
+        }
+        return;
+      }
+      if (context->remaining_.fetch_sub(1) == 1 && !context->failed_.load()) {
+        context->Finish();
+      }
+    }), true);
+  }
+  return result;
+}
+
+// Future of the index and the value of the first future to complete
+// (just the index for void futures). Its exception, if any, is passed on.
+template <class T>
+auto WhenAny(std::vector<Future<T>> futures) {
+  using R = typename std::conditional<std::is_void<T>::value, size_t,
+                                      std::pair<size_t, StoredType<T>>>::type;
+  if (futures.empty()) {
+    throw std::invalid_argument("WhenAny of no futures");
+  }
+  struct Context {
+    explicit Context(Executor* executor) : promise_(executor) {}
+    
+    std::atomic<bool> done_{false};
+    Promise<R> promise_;
+  };
+  
+  auto context = std::make_shared<Context>(futures.front().state_->GetExecutor());
+  Future<R> result = context->promise_.GetFuture();
+  for (size_t i = 0; i < futures.size(); ++i) {
+    std::shared_ptr<FutureState<T>> state = std::move(futures[i].state_);
+    state->Subscribe(Task([context, state, i]() {
+      if (context->done_.exchange(true)) {
+        return;
+      }
+      try {
+        if constexpr (std::is_void<T>::value) {
+          state->TakeValue();
+          context->promise_.SetValue(i);
+        } else {
+          context->promise_.SetValue({i, state->TakeValue()});
+        }
+      } catch (...) {
+        context->promise_.SetException(std::current_exception());
+      }
+    }), true);
+  }
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,319 @@
+//
+//  parallel_algorithms.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include "solution.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Parallel algorithms on top of ThreadPool.
+// A range is split in halves recursively: one half goes to the pool, the other
+// one is processed by the current thread, which then takes the first half back
+// if nobody has started it, or executes queued chunks while waiting for it,
+// so the caller takes part in the work instead of blocking (see ForkedHalf).
+// A non-zero grain splits the range down to chunks of at most grain elements.
+// grain = 0 splits adaptively (lazy binary splitting): a range is split only
+// while the pool has fewer queued tasks than workers, i.e. while some worker
+// would otherwise be idle; if not, the thread processes the range sequentially
+// chunk by chunk and checks again between chunks. Chunks are not smaller than
+// 1 / kMaxChunksPerWorker of a worker's share, so the checks stay cheap.
+//
+// usage:
+// ParallelFor(pool, 0, n, [&](size_t i) { a[i] *= 2; });
+// long sum = ParallelReduce(pool, v.begin(), v.end(), 0L, std::plus<long>());
+//
+
+///////////////////////////////////////////////////////////////////////
+
+constexpr size_t kMaxChunksPerWorker = 64;
+
+// How a range is split, see above.
+struct ParallelGrain {
+  size_t size_;
+  bool adaptive_;
+};
+
+template <class Pool>
+ParallelGrain MakeParallelGrain(const Pool& pool, const size_t size, const size_t grain) {
+  if (grain != 0) {
+    return {grain, false};
+  }
+  const size_t chunks = kMaxChunksPerWorker * std::max<size_t>(pool.NumWorkers(), 1);
+  return {std::max<size_t>(size / chunks, 1), true};
+}
+
+// Whether a range longer than the grain should be split now.
+template <class Pool>
+bool ShouldSplit(const Pool& pool, const ParallelGrain& grain) {
+  return !grain.adaptive_ || pool.NumPendingTasks() < pool.NumWorkers();
+}
+
+// One half of a range forked into the pool.
+// Join() runs the half on the calling thread if no worker has started it yet
+// (the queued task then finds it taken and does nothing); otherwise it waits
+// for the half, executing other queued tasks meanwhile. So a join never waits
+// for a task that is still queued, which keeps the helping from nesting deeply
+// (and the stack from overflowing) when the pool is flooded with small chunks.
+template <class F>
+class ForkedHalf {
+ public:
+  using Result = decltype(std::declval<F&>()());
+  
+  template <class Pool>
+  ForkedHalf(Pool& pool, F f)
+      : taken_(std::allocate_shared<std::atomic<bool>>(PoolAllocator<std::atomic<bool>>(), false)),
+        f_(f) {
+    future_ = pool.Async([taken = taken_, f]() mutable -> std::optional<StoredType<Result>> {
+      if (taken->exchange(true)) {
+        return std::nullopt;
+      }
+      return Call(f);
+    });
+  }
+  
+  Result Join() {
+    if (!taken_->exchange(true)) {
+      return f_();
+    }
+    future_.WaitHelping();
+    std::optional<StoredType<Result>> result = future_.Get();
+    if constexpr (!std::is_void<Result>::value) {
+      return std::move(*result);
+    }
+  }
+  
+  // Drops the half if it hasn't started, otherwise waits for it to finish.
+  // The half refers to the caller's stack, so this has to be done
+  // before an exception leaves the caller.
+  void Cancel() {
+    if (taken_->exchange(true)) {
+      future_.WaitHelping();
+    }
+  }
+  
+ private:
+  static StoredType<Result> Call(F& f) {
+    if constexpr (std::is_void<Result>::value) {
+      f();
+      return Unit{};
+    } else {
+      return f();
+    }
+  }
+  
+  std::shared_ptr<std::atomic<bool>> taken_;
+  F f_;
+  Future<std::optional<StoredType<Result>>> future_;
+};
+
+template <class Pool, class F>
+ForkedHalf<F> Fork(Pool& pool, F f) {
+  return ForkedHalf<F>(pool, std::move(f));
+}
+
+// Runs f() on the current thread while the forked half runs in the pool.
+template <class Forked, class F>
+decltype(auto) RunBeside(Forked& forked, F&& f) {
+  try {
+    return f();
+  } catch (...) {
+    forked.Cancel();
+    throw;
+  }
+}
+
+// Calls body(lo, hi) for disjoint chunks covering [lo, hi).
+template <class Pool, class Body>
+void ForEachChunk(Pool& pool, size_t lo, const size_t hi, const ParallelGrain grain, Body& body) {
+  while (hi - lo > grain.size_) {
+    if (ShouldSplit(pool, grain)) {
+      const size_t mid = lo + (hi - lo) / 2;
+      auto right = Fork(pool, [&pool, mid, hi, grain, &body]() { ForEachChunk(pool, mid, hi, grain, body); });
+      RunBeside(right, [&]() { ForEachChunk(pool, lo, mid, grain, body); });
+      right.Join();
+      return;
+    }
+    body(lo, lo + grain.size_);
+    lo += grain.size_;
+  }
+  body(lo, hi);
+}
+
+// T need not be default-constructible: partial results are kept in an optional.
+template <class Pool, class Iterator, class T, class BinaryOp>
+T ReduceChunks(Pool& pool, Iterator first, size_t lo, const size_t hi, const ParallelGrain grain,
+               BinaryOp& op) {
+  std::optional<T> total;
+  auto fold = [&total, &op](T&& value) {
+    if (total) {
+      total.emplace(op(std::move(*total), std::move(value)));
+    } else {
+      total.emplace(std::move(value));
+    }
+  };
+  while (hi - lo > grain.size_) {
+    if (ShouldSplit(pool, grain)) {
+      const size_t mid = lo + (hi - lo) / 2;
+      auto right = Fork(pool, [&pool, first, mid, hi, grain, &op]() {
+        return ReduceChunks<Pool, Iterator, T, BinaryOp>(pool, first, mid, hi, grain, op);
+      });
+      fold(RunBeside(right, [&]() {
+        return ReduceChunks<Pool, Iterator, T, BinaryOp>(pool, first, lo, mid, grain, op);
+      }));
+      fold(right.Join());
+      return std::move(*total);
+    }
+    fold(std::accumulate(first + lo + 1, first + lo + grain.size_, T(first[lo]), op));
+    lo += grain.size_;
+  }
+  fold(std::accumulate(first + lo + 1, first + hi, T(first[lo]), op));
+  return std::move(*total);
+}
+
+// Moves the merge of the sorted runs [lo1, hi1) and [lo2, hi2) of from
+// to the positions of to starting at out. Each step puts the middle element
+// of the longer run into its final place and merges both sides of it in parallel.
+// Equal elements of the first run go first.
+template <class Pool, class From, class To, class Compare>
+void MergeChunks(Pool& pool, From from, size_t lo1, size_t hi1, size_t lo2, size_t hi2, To to, size_t out,
+                 const ParallelGrain grain, Compare& comp) {
+  if ((hi1 - lo1) + (hi2 - lo2) <= grain.size_ || !ShouldSplit(pool, grain)) {
+    std::merge(std::make_move_iterator(from + lo1), std::make_move_iterator(from + hi1),
+               std::make_move_iterator(from + lo2), std::make_move_iterator(from + hi2), to + out, comp);
+    return;
+  }
+  size_t mid1;
+  size_t mid2;
+  size_t pivot;
+  // The runs on the right of the pivot start after it.
+  size_t next1;
+  size_t next2;
+  if (hi1 - lo1 >= hi2 - lo2) {
+    pivot = mid1 = lo1 + (hi1 - lo1) / 2;
+    mid2 = std::lower_bound(from + lo2, from + hi2, from[pivot], comp) - from;
+    next1 = mid1 + 1;
+    next2 = mid2;
+  } else {
+    pivot = mid2 = lo2 + (hi2 - lo2) / 2;
+    mid1 = std::upper_bound(from + lo1, from + hi1, from[pivot], comp) - from;
+    next1 = mid1;
+    next2 = mid2 + 1;
+  }
+  const size_t out_pivot = out + (mid1 - lo1) + (mid2 - lo2);
+  to[out_pivot] = std::move(from[pivot]);
+  auto right = Fork(pool, [&pool, from, next1, hi1, next2, hi2, to, out_pivot, grain, &comp]() {
+    MergeChunks(pool, from, next1, hi1, next2, hi2, to, out_pivot + 1, grain, comp);
+  });
+  RunBeside(right, [&]() { MergeChunks(pool, from, lo1, mid1, lo2, mid2, to, out, grain, comp); });
+  right.Join();
+}
+
+// Sorts the elements at [lo, hi) of from. The result goes to the same positions
+// of to if into_to is set, otherwise it stays in from; the other array is
+// the scratch space. The halves are sorted into the array opposite to the result
+// and merged from there.
+template <class Pool, class From, class To, class Compare>
+void SortChunks(Pool& pool, From from, To to, const size_t lo, const size_t hi, const ParallelGrain grain,
+                Compare& comp, const bool into_to) {
+  if (hi - lo <= grain.size_ || !ShouldSplit(pool, grain)) {
+    std::sort(from + lo, from + hi, comp);
+    if (into_to) {
+      std::move(from + lo, from + hi, to + lo);
+    }
+    return;
+  }
+  const size_t mid = lo + (hi - lo) / 2;
+  auto right = Fork(pool, [&pool, from, to, mid, hi, grain, &comp, into_to]() {
+    SortChunks(pool, from, to, mid, hi, grain, comp, !into_to);
+  });
+  RunBeside(right, [&]() { SortChunks(pool, from, to, lo, mid, grain, comp, !into_to); });
+  right.Join();
+  if (into_to) {
+    MergeChunks(pool, from, lo, mid, mid, hi, to, lo, grain, comp);
+  } else {
+    MergeChunks(pool, to, lo, mid, mid, hi, from, lo, grain, comp);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Calls fn(i) for every i in [begin, end).
+template <class Pool, class Index, class F>
+void ParallelFor(Pool& pool, const Index begin, const Index end, F fn, const size_t grain = 0) {
+  if (!(begin < end)) {
+    return;
+  }
+  const size_t size = static_cast<size_t>(end - begin);
+  auto body = [begin, &fn](const size_t lo, const size_t hi) {
+    for (size_t i = lo; i < hi; ++i) {
+      fn(static_cast<Index>(begin + i));
+    }
+  };
+  ForEachChunk(pool, 0, size, MakeParallelGrain(pool, size, grain), body);
+}
+
+// Folds [first, last) with an associative op, init is combined with the total once.
+template <class Pool, class RandomIt, class T, class BinaryOp = std::plus<T>>
+T ParallelReduce(Pool& pool, RandomIt first, RandomIt last, T init, BinaryOp op = BinaryOp(),
+                 const size_t grain = 0) {
+  if (first == last) {
+    return init;
+  }
+  const size_t size = static_cast<size_t>(last - first);
+  T total = ReduceChunks<Pool, RandomIt, T, BinaryOp>(
+      pool, first, 0, size, MakeParallelGrain(pool, size, grain), op);
+  return op(std::move(init), std::move(total));
+}
+
+// out[i] = fn(first[i]) for every element of [first, last); returns the end of the output.
+template <class Pool, class RandomIt, class OutputIt, class F>
+OutputIt ParallelTransform(Pool& pool, RandomIt first, RandomIt last, OutputIt out, F fn,
+                           const size_t grain = 0) {
+  const size_t size = static_cast<size_t>(last - first);
+  if (size == 0) {
+    return out;
+  }
+  auto body = [first, out, &fn](const size_t lo, const size_t hi) {
+    std::transform(first + lo, first + hi, out + lo, fn);
+  };
+  ForEachChunk(pool, 0, size, MakeParallelGrain(pool, size, grain), body);
+  return out + size;
+}
+
+// Merge sort: chunks are sorted with std::sort in parallel, and the sorted halves
+// are merged with a parallel merge through a buffer of the same size.
+// The elements are moved into the buffer sequentially before sorting,
+// which is one pass of moves against log(n) levels of parallel merges.
+template <class Pool, class RandomIt, class Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+void ParallelSort(Pool& pool, RandomIt first, RandomIt last, Compare comp = Compare(),
+                  const size_t grain = 0) {
+  const size_t size = static_cast<size_t>(last - first);
+  if (size < 2) {
+    return;
+  }
+  const ParallelGrain chunking = MakeParallelGrain(pool, size, grain);
+  if (size <= chunking.size_ || !ShouldSplit(pool, chunking)) {
+    std::sort(first, last, comp);
+    return;
+  }
+  using Value = typename std::iterator_traits<RandomIt>::value_type;
+  std::vector<Value> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+  SortChunks(pool, buffer.begin(), first, 0, size, chunking, comp, true);
+}
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,144 @@
+//
+//  pool_allocator.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// Standard-compatible allocator that recycles single-object blocks.
+// Every thread keeps a free list per object type, so most allocations and
+// deallocations touch no shared memory. Blocks often die on a different thread
+// than the one that allocated them (e.g. promise states of a thread pool are
+// allocated by submitters and freed by workers), so a thread that has accumulated
+// too many free blocks hands a batch of them over to a global list under a mutex,
+// and a thread that runs out of blocks takes a whole batch back.
+template <class T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+  
+  PoolAllocator() = default;
+  
+  template <class U>
+  PoolAllocator(const PoolAllocator<U>&) {}
+  
+  T* allocate(const size_t n) {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not supported");
+    if (n != 1) {
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return static_cast<T*>(LocalFreeList().Pop());
+  }
+  
+  void deallocate(T* ptr, const size_t n) {
+    if (n != 1) {
+      ::operator delete(ptr);
+      return;
+    }
+    LocalFreeList().Push(ptr);
+  }
+  
+  template <class U>
+  bool operator==(const PoolAllocator<U>&) const {
+    return true;
+  }
+  
+  template <class U>
+  bool operator!=(const PoolAllocator<U>&) const {
+    return false;
+  }
+  
+ private:
+  static constexpr size_t kBatchSize = 64;
+  
+  struct Block {
+    Block* next_;
+  };
+  
+  static constexpr size_t BlockSize() {
+    return std::max(sizeof(T), sizeof(Block));
+  }
+  
+  // Batches of kBatchSize blocks each, linked through Block::next_.
+  struct GlobalFreeList {
+    std::mutex mutex_;
+    std::vector<Block*> batches_;
+  };
+  
+  // Never destroyed: thread-local lists may give batches back during thread exit.
+  static GlobalFreeList& Global() {
+    static GlobalFreeList* global = new GlobalFreeList();
+    return *global;
+  }
+  
+  class FreeList {
+   public:
+    ~FreeList() {
+      while (head_ != nullptr) {
+        Block* next = head_->next_;
+        ::operator delete(head_);
+        head_ = next;
+      }
+    }
+    
+    void* Pop() {
+      if (head_ == nullptr) {
+        TakeBatch();
+      }
+      if (head_ == nullptr) {
+        return ::operator new(BlockSize());
+      }
+      Block* block = head_;
+      head_ = block->next_;
+      --size_;
+      return block;
+    }
+    
+    void Push(void* ptr) {
+      head_ = new (ptr) Block{head_};
+      ++size_;
+      if (size_ == 2 * kBatchSize) {
+        GiveBatch();
+      }
+    }
+    
+   private:
+    void TakeBatch() {
+      GlobalFreeList& global = Global();
+      std::unique_lock<std::mutex> lock(global.mutex_);
+      if (!global.batches_.empty()) {
+        head_ = global.batches_.back();
+        global.batches_.pop_back();
+        size_ = kBatchSize;
+      }
+    }
+    
+    // Keeps kBatchSize blocks and gives away the rest.
+    void GiveBatch() {
+      Block* last_kept = head_;
+      for (size_t i = 1; i < kBatchSize; ++i) {
+        last_kept = last_kept->next_;
+      }
+      Block* batch = last_kept->next_;
+      last_kept->next_ = nullptr;
+      size_ = kBatchSize;
+      GlobalFreeList& global = Global();
+      std::unique_lock<std::mutex> lock(global.mutex_);
+      global.batches_.push_back(batch);
+    }
+    
+    Block* head_{nullptr};
+    size_t size_{0};
+  };
+  
+  static FreeList& LocalFreeList() {
+    static thread_local FreeList free_list;
+    return free_list;
+  }
+};
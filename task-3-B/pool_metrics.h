@@ -0,0 +1,202 @@
+//
+//  pool_metrics.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Default of the kMetrics parameter of ThreadPool: metrics are compiled in
+// only with -DTHREAD_POOL_METRICS. Without them ThreadPool doesn't touch
+// anything declared here, and Stats() reports only the number of workers
+// and the queue depth.
+#ifdef THREAD_POOL_METRICS
+constexpr bool kThreadPoolMetricsEnabled = true;
+#else
+constexpr bool kThreadPoolMetricsEnabled = false;
+#endif
+
+// Every task is counted, but only every kMetricsSamplePeriod-th task submitted
+// by a thread is timed: the clock reads and the histogram updates are most
+// of the cost of the metrics, and a sample is enough for the percentiles.
+constexpr size_t kMetricsSamplePeriod = 64;
+
+// Log-linear histogram of durations in nanoseconds: every power of two is split
+// into kSubBuckets equal buckets, so the relative error is at most 1 / kSubBuckets
+// and the whole 64-bit range fits into a few hundred counters.
+class HistogramSnapshot {
+ public:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = size_t(1) << kSubBucketBits;
+  static constexpr size_t kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t BucketOf(const uint64_t value) {
+    if (value < kSubBuckets) {
+      return value;
+    }
+    const size_t exponent = 63 - __builtin_clzll(value);
+    const size_t sub_bucket = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + sub_bucket;
+  }
+
+  // The smallest value that falls into the bucket.
+  static uint64_t LowerBound(const size_t bucket) {
+    if (bucket < kSubBuckets) {
+      return bucket;
+    }
+    const size_t exponent = bucket / kSubBuckets + kSubBucketBits - 1;
+    const uint64_t sub_bucket = bucket % kSubBuckets;
+    return (kSubBuckets + sub_bucket) << (exponent - kSubBucketBits);
+  }
+
+  void Merge(const HistogramSnapshot& other) {
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+  }
+
+  uint64_t Count() const {
+    return count_;
+  }
+
+  uint64_t Mean() const {
+    return count_ == 0 ? 0 : sum_ / count_;
+  }
+
+  // Lower bound of the bucket that holds the given quantile, quantile in [0, 1].
+  uint64_t Percentile(const double quantile) const {
+    if (count_ == 0) {
+      return 0;
+    }
+    const uint64_t rank = static_cast<uint64_t>(quantile * (count_ - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return LowerBound(i);
+      }
+    }
+    return LowerBound(kNumBuckets - 1);
+  }
+
+ private:
+  friend class LatencyHistogram;
+
+  std::array<uint64_t, kNumBuckets> counts_{};
+  uint64_t count_{0};
+  uint64_t sum_{0};
+};
+
+// Recording side of HistogramSnapshot. It has a single writer (the thread that owns it),
+// so Record() is plain relaxed loads and stores without read-modify-write,
+// while Snapshot() may be called from any thread at any time.
+class LatencyHistogram {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  void Record(const Clock::duration duration) {
+    const uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+    Increment(counts_[HistogramSnapshot::BucketOf(nanoseconds)], 1);
+    Increment(count_, 1);
+    Increment(sum_, nanoseconds);
+  }
+
+  HistogramSnapshot Snapshot() const {
+    HistogramSnapshot snapshot;
+    for (size_t i = 0; i < HistogramSnapshot::kNumBuckets; ++i) {
+      snapshot.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+    }
+    snapshot.count_ = count_.load(std::memory_order_relaxed);
+    snapshot.sum_ = sum_.load(std::memory_order_relaxed);
+    return snapshot;
+  }
+
+ private:
+  static void Increment(std::atomic<uint64_t>& counter, const uint64_t delta) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+  }
+
+  std::array<std::atomic<uint64_t>, HistogramSnapshot::kNumBuckets> counts_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+};
+
+struct WorkerStats {
+  uint64_t tasks_executed = 0;
+  // Of the sampled tasks: time from putting a task into the queue until
+  // a worker took it, and the time it ran.
+  HistogramSnapshot queue_wait;
+  HistogramSnapshot execution;
+
+  void Merge(const WorkerStats& other) {
+    tasks_executed += other.tasks_executed;
+    queue_wait.Merge(other.queue_wait);
+    execution.Merge(other.execution);
+  }
+};
+
+// Metrics of one worker. Every worker thread keeps its own instance
+// in thread-local storage (see Local()) and is the only one writing it.
+class WorkerMetrics {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  static WorkerMetrics& Local() {
+    thread_local WorkerMetrics metrics;
+    return metrics;
+  }
+
+  void Record(const Clock::time_point enqueued, const Clock::time_point started,
+              const Clock::time_point finished) {
+    queue_wait_.Record(started - enqueued);
+    execution_.Record(finished - started);
+    CountTask();
+  }
+
+  // A task that is not in the sample.
+  void CountTask() {
+    tasks_executed_.store(tasks_executed_.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+  }
+
+  WorkerStats Snapshot() const {
+    WorkerStats stats;
+    stats.tasks_executed = tasks_executed_.load(std::memory_order_relaxed);
+    stats.queue_wait = queue_wait_.Snapshot();
+    stats.execution = execution_.Snapshot();
+    return stats;
+  }
+
+ private:
+  std::atomic<uint64_t> tasks_executed_{0};
+  LatencyHistogram queue_wait_;
+  LatencyHistogram execution_;
+};
+
+struct ThreadPoolStats {
+  size_t num_workers = 0;
+  size_t queue_depth = 0;
+  // One entry per live worker; empty for a pool without metrics.
+  std::vector<WorkerStats> workers;
+  // Everything recorded by workers that have already exited.
+  WorkerStats retired;
+  // Tasks that threads outside the pool ran while waiting for a Future.
+  WorkerStats helpers;
+
+  WorkerStats Total() const {
+    WorkerStats total = retired;
+    total.Merge(helpers);
+    for (const WorkerStats& worker: workers) {
+      total.Merge(worker);
+    }
+    return total;
+  }
+};
@@ -0,0 +1,424 @@
+//
+//  priority_blocking_queue.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+enum class TaskPriority {
+  kHigh = 0,
+  kNormal = 1,
+  kLow = 2
+};
+
+// Blocking Queue with several priority levels and deadlines.
+// Elements put with PutWithDeadline form one more source next to the levels,
+// ordered by deadline. Get() takes from, in this order:
+// - the highest level that has been passed over by max_skips Get()s in a row
+//   while non-empty (so low priorities can't starve); the deadline source
+//   counts as the lowest level here;
+// - the deadline source, if its earliest deadline is due, i.e. less than
+//   deadline_margin away;
+// - the highest non-empty level;
+// - the deadline source.
+// So a deadline far in the future doesn't overtake prioritized work,
+// and a flood of due deadlines doesn't starve the levels either.
+//
+// Every level and the deadline source have their own lock, so producers
+// of different priorities don't contend. The number of available elements
+// is an atomic: a consumer first claims an element by decrementing it,
+// then picks a source by lock-free hints and takes the element under the lock
+// of that source only. The mutex and the condition variables are touched
+// only when somebody actually sleeps.
+//
+// Every kTimestampEvery-th element put by a thread remembers when it was put,
+// and Get() and friends can return that time. For the other elements (all of
+// them if kTimestampEvery is 0) Put() doesn't read the clock, and the returned
+// time is Clock::time_point().
+template <class T, size_t kTimestampEvery = 1>
+class PriorityBlockingQueue {
+ public:
+  using Clock = std::chrono::steady_clock;
+  
+  static constexpr size_t kNumPriorities = 3;
+  
+  explicit PriorityBlockingQueue(const size_t& capacity,
+                                 const size_t max_skips = 32,
+                                 const Clock::duration deadline_margin = std::chrono::milliseconds(1))
+      : capacity_(capacity),
+        max_skips_(max_skips),
+        deadline_margin_(deadline_margin) {}
+  
+  // Works like BlockingQueue::Put: waits while the queue is full
+  // and throws std::exception if the queue is shutted down.
+  void Put(T&& element, const TaskPriority priority = TaskPriority::kNormal) {
+    AcquireSlot();
+    Level& level = levels_[static_cast<size_t>(priority)];
+    try {
+      std::unique_lock<std::mutex> lock(level.mtx_);
+      level.entries_.push_back({std::move(element), EnqueueTime()});
+      OnPushed(level, level.entries_.size());
+    } catch (...) {
+      ReleaseSlot();
+      throw;
+    }
+    Publish();
+  }
+  
+  void PutWithDeadline(T&& element, const Clock::time_point deadline) {
+    AcquireSlot();
+    try {
+      std::unique_lock<std::mutex> lock(deadlines_.mtx_);
+      auto& heap = deadlines_.entries_;
+      heap.push_back({std::move(element), deadline, deadlines_.next_sequence_++, EnqueueTime()});
+      std::push_heap(heap.begin(), heap.end(), LaterDeadline());
+      deadlines_.earliest_.store(heap.front().deadline_.time_since_epoch().count(),
+                                 std::memory_order_relaxed);
+      OnPushed(deadlines_, heap.size());
+    } catch (...) {
+      ReleaseSlot();
+      throw;
+    }
+    Publish();
+  }
+  
+  // Same contract as BlockingQueue::Get: returns false only if the queue
+  // is shutted down and empty. If enqueued is not null, it receives
+  // the time the element was put into the queue.
+  bool Get(T& result, Clock::time_point* enqueued = nullptr) {
+    if (!Claim(nullptr, NeverStop)) {
+      return false;
+    }
+    Pop(result, enqueued);
+    return true;
+  }
+  
+  // Like Get, but also returns false if nothing comes within timeout.
+  bool GetFor(T& result, const Clock::duration timeout, Clock::time_point* enqueued = nullptr) {
+    const Clock::time_point deadline = Clock::now() + timeout;
+    if (!Claim(&deadline, NeverStop)) {
+      return false;
+    }
+    Pop(result, enqueued);
+    return true;
+  }
+  
+  // Like Get, but returns false as soon as stop() is true, without taking anything.
+  // stop() is checked under the wait mutex, so whoever makes it true
+  // has to call WakeAll() afterwards to reach a thread that is already asleep.
+  template <class Stop>
+  bool GetUnless(T& result, Stop stop, Clock::time_point* enqueued = nullptr) {
+    if (!Claim(nullptr, stop)) {
+      return false;
+    }
+    Pop(result, enqueued);
+    return true;
+  }
+  
+  size_t Size() const {
+    return available_.load();
+  }
+  
+  // Never waits: returns false if the queue is empty.
+  bool TryGet(T& result, Clock::time_point* enqueued = nullptr) {
+    if (!TryClaim()) {
+      return false;
+    }
+    Pop(result, enqueued);
+    return true;
+  }
+  
+  // Forbids writing and notifies all threads.
+  void Shutdown() {
+    queue_is_shutted_.store(true);
+    std::unique_lock<std::mutex> lock(wait_mtx_);
+    queue_is_not_empty_cv_.notify_all();
+    queue_is_not_full_cv_.notify_all();
+  }
+  
+  // Wakes up all threads waiting in Get(), GetFor() or GetUnless().
+  void WakeAll() {
+    std::unique_lock<std::mutex> lock(wait_mtx_);
+    queue_is_not_empty_cv_.notify_all();
+  }
+  
+ private:
+  struct Entry {
+    T element_;
+    Clock::time_point enqueued_;
+  };
+  
+  struct DeadlineEntry {
+    T element_;
+    Clock::time_point deadline_;
+    // Elements with equal deadlines are taken in FIFO order.
+    size_t sequence_;
+    Clock::time_point enqueued_;
+  };
+  
+  // std::push_heap builds a max-heap, so "less" means "later".
+  struct LaterDeadline {
+    bool operator()(const DeadlineEntry& lhs, const DeadlineEntry& rhs) const {
+      if (lhs.deadline_ != rhs.deadline_) {
+        return lhs.deadline_ > rhs.deadline_;
+      }
+      return lhs.sequence_ > rhs.sequence_;
+    }
+  };
+  
+  // A level or the deadline heap. size_ and served_at_ are written under mtx_
+  // and read without it as hints for picking a source.
+  struct alignas(64) Source {
+    std::mutex mtx_;
+    std::atomic<size_t> size_{0};
+    // Value of pops_ when the source was last served or became non-empty.
+    std::atomic<uint64_t> served_at_{0};
+  };
+  
+  struct Level : Source {
+    std::deque<Entry> entries_;
+  };
+  
+  struct DeadlineHeap : Source {
+    std::vector<DeadlineEntry> entries_;
+    size_t next_sequence_{0};
+    // Earliest deadline in the heap, in Clock ticks.
+    std::atomic<Clock::rep> earliest_{0};
+  };
+  
+  static Clock::time_point EnqueueTime() {
+    if constexpr (kTimestampEvery == 0) {
+      return Clock::time_point();
+    } else if constexpr (kTimestampEvery == 1) {
+      return Clock::now();
+    } else {
+      thread_local size_t puts = 0;
+      return ++puts % kTimestampEvery == 0 ? Clock::now() : Clock::time_point();
+    }
+  }
+  
+  // Index of the deadline source in PickSource().
+  static constexpr size_t kDeadlineSource = kNumPriorities;
+  
+  // Must be called under the lock of the source.
+  void OnPushed(Source& source, const size_t size) {
+    if (size == 1) {
+      source.served_at_.store(pops_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    source.size_.store(size, std::memory_order_relaxed);
+  }
+  
+  // Takes a place in the queue: waits while it is full,
+  // throws std::exception if the queue is shutted down.
+  void AcquireSlot() {
+    size_t occupied = occupied_.load();
+    while (true) {
+      if (queue_is_shutted_.load()) {
+        throw std::exception();
+      }
+      if (occupied < capacity_) {
+        if (occupied_.compare_exchange_weak(occupied, occupied + 1)) {
+          break;
+        }
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wait_mtx_);
+      space_waiters_.fetch_add(1);
+      queue_is_not_full_cv_.wait(lock, [this]() {
+        return occupied_.load() < capacity_ || queue_is_shutted_.load();
+      });
+      space_waiters_.fetch_sub(1);
+      occupied = occupied_.load();
+    }
+    // Either Claim() sees our place taken after the shutdown and waits
+    // for the element, or we see the shutdown here.
+    if (queue_is_shutted_.load()) {
+      ReleaseSlot();
+      throw std::exception();
+    }
+  }
+  
+  void ReleaseSlot() {
+    occupied_.fetch_sub(1);
+    if (space_waiters_.load() != 0) {
+      std::unique_lock<std::mutex> lock(wait_mtx_);
+      queue_is_not_full_cv_.notify_one();
+    }
+  }
+  
+  // available_ and waiters_ are seq_cst: either a sleeping consumer sees
+  // the new element, or we see the consumer and wake it up.
+  void Publish() {
+    available_.fetch_add(1);
+    if (waiters_.load() != 0) {
+      std::unique_lock<std::mutex> lock(wait_mtx_);
+      queue_is_not_empty_cv_.notify_one();
+    }
+  }
+  
+  bool TryClaim() {
+    size_t available = available_.load();
+    while (available != 0) {
+      if (available_.compare_exchange_weak(available, available - 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+  
+  static bool NeverStop() {
+    return false;
+  }
+  
+  // Claims an element, waiting until deadline (forever if it is null).
+  // Returns false on timeout, once stop() is true,
+  // or if the queue is shutted down and empty.
+  template <class Stop>
+  bool Claim(const Clock::time_point* deadline, Stop& stop) {
+    while (true) {
+      if (stop()) {
+        return false;
+      }
+      if (TryClaim()) {
+        return true;
+      }
+      if (queue_is_shutted_.load()) {
+        if (occupied_.load() == 0) {
+          return false;
+        }
+        // A Put() that got its place before the shutdown is still
+        // publishing its element (or somebody is taking the last one).
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(wait_mtx_);
+      waiters_.fetch_add(1);
+      auto ready = [this, &stop]() {
+        return available_.load() != 0 || queue_is_shutted_.load() || stop();
+      };
+      bool woken = true;
+      if (deadline == nullptr) {
+        queue_is_not_empty_cv_.wait(lock, ready);
+      } else {
+        woken = queue_is_not_empty_cv_.wait_until(lock, *deadline, ready);
+      }
+      waiters_.fetch_sub(1);
+      if (!woken) {
+        return TryClaim();
+      }
+    }
+  }
+  
+  // The caller must have claimed an element. Every claim is backed by an element
+  // that is already in one of the sources, but another consumer may take the one
+  // the hints pointed at, so the choice is repeated until it succeeds.
+  void Pop(T& result, Clock::time_point* enqueued) {
+    while (!TryPop(PickSource(), result, enqueued)) {
+    }
+    ReleaseSlot();
+  }
+  
+  bool TryPop(const size_t source, T& result, Clock::time_point* enqueued) {
+    if (source == kDeadlineSource) {
+      std::unique_lock<std::mutex> lock(deadlines_.mtx_);
+      auto& heap = deadlines_.entries_;
+      if (heap.empty()) {
+        return false;
+      }
+      std::pop_heap(heap.begin(), heap.end(), LaterDeadline());
+      result = std::move(heap.back().element_);
+      if (enqueued != nullptr) {
+        *enqueued = heap.back().enqueued_;
+      }
+      heap.pop_back();
+      if (!heap.empty()) {
+        deadlines_.earliest_.store(heap.front().deadline_.time_since_epoch().count(),
+                                   std::memory_order_relaxed);
+      }
+      OnPopped(deadlines_, heap.size());
+      return true;
+    }
+    Level& level = levels_[source];
+    std::unique_lock<std::mutex> lock(level.mtx_);
+    if (level.entries_.empty()) {
+      return false;
+    }
+    result = std::move(level.entries_.front().element_);
+    if (enqueued != nullptr) {
+      *enqueued = level.entries_.front().enqueued_;
+    }
+    level.entries_.pop_front();
+    OnPopped(level, level.entries_.size());
+    return true;
+  }
+  
+  // Must be called under the lock of the source.
+  void OnPopped(Source& source, const size_t size) {
+    source.size_.store(size, std::memory_order_relaxed);
+    source.served_at_.store(pops_.fetch_add(1, std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+  }
+  
+  Source& SourceAt(const size_t source) {
+    if (source == kDeadlineSource) {
+      return deadlines_;
+    }
+    return levels_[source];
+  }
+  
+  // Picks a source by the hints, see the order in the class comment.
+  size_t PickSource() {
+    const uint64_t pops = pops_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= kDeadlineSource; ++i) {
+      Source& source = SourceAt(i);
+      // served_at_ may be newer than pops, hence the signed difference.
+      const int64_t skipped = static_cast<int64_t>(pops - source.served_at_.load(std::memory_order_relaxed));
+      if (source.size_.load(std::memory_order_relaxed) != 0 && skipped >= static_cast<int64_t>(max_skips_)) {
+        return i;
+      }
+    }
+    if (deadlines_.size_.load(std::memory_order_relaxed) != 0) {
+      const Clock::rep due_before = (Clock::now() + deadline_margin_).time_since_epoch().count();
+      if (deadlines_.earliest_.load(std::memory_order_relaxed) <= due_before) {
+        return kDeadlineSource;
+      }
+    }
+    for (size_t i = 0; i < kNumPriorities; ++i) {
+      if (levels_[i].size_.load(std::memory_order_relaxed) != 0) {
+        return i;
+      }
+    }
+    return kDeadlineSource;
+  }
+  
+  const size_t capacity_;
+  const size_t max_skips_;
+  const Clock::duration deadline_margin_;
+  std::array<Level, kNumPriorities> levels_;
+  DeadlineHeap deadlines_;
+  // Elements that are published and not claimed yet.
+  alignas(64) std::atomic<size_t> available_{0};
+  // Places taken by Put()s, released when the element is taken out.
+  alignas(64) std::atomic<size_t> occupied_{0};
+  // Number of elements taken out so far, the clock of the starvation protection.
+  alignas(64) std::atomic<uint64_t> pops_{0};
+  std::atomic<size_t> waiters_{0};
+  std::atomic<size_t> space_waiters_{0};
+  std::atomic<bool> queue_is_shutted_{false};
+  std::mutex wait_mtx_;
+  std::condition_variable queue_is_not_empty_cv_;
+  std::condition_variable queue_is_not_full_cv_;
+};
@@ -8,6 +8,18 @@
 
 #pragma once
 
+#include "future.h"
+#include "pool_allocator.h"
+#include "pool_metrics.h"
+#include "priority_blocking_queue.h"
+#include "task.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -16,6 +28,10 @@
 #include <queue>
 #include <stdexcept>
 #include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 
 // Blocking Queue that works with several threads.
 template <class T, class Container = std::deque<T>>
@@ -84,21 +100,49 @@ class BlockingQueue {
   std::mutex mtx_;
 };
 
+// Worker bounds of ThreadPool. The pool starts min_workers workers and grows up
+// to max_workers when tasks queue up or block; a worker above min_workers
+// that has been idle for idle_timeout exits. min_workers == max_workers
+// gives a fixed pool. pin_to_cpus binds worker i to CPU i % number of CPUs.
+struct ThreadPoolOptions {
+  static size_t DefaultNumWorkers() {
+    return std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 10;
+  }
+  
+  size_t min_workers = DefaultNumWorkers();
+  size_t max_workers = DefaultNumWorkers();
+  std::chrono::steady_clock::duration idle_timeout = std::chrono::seconds(1);
+  bool pin_to_cpus = false;
+};
+
 // Thread pool that distributes tasks between several threads.
-template <class T>
-class ThreadPool {
+// Tasks are taken by priority (see PriorityBlockingQueue), FIFO within a priority level.
+// Submit(f, args...) accepts any callable with any return type; T is only the result type
+// of the Submit(std::function<T()>) overloads kept for the typed interface.
+// Queued tasks are type-erased into Task (small callables are stored inline),
+// and promise states come from PoolAllocator, so a small task doesn't hit the heap.
+// Async(f, args...) returns a Future with continuations (see future.h) instead of std::future;
+// continuations are scheduled back onto the pool, and a worker waiting for a Future
+// runs other tasks meanwhile, sleeping in the task queue when there are none.
+//
+// kMetrics compiles in the runtime metrics of Stats() (see pool_metrics.h).
+template <class T = void, bool kMetrics = kThreadPoolMetricsEnabled>
+class ThreadPool : public Executor {
  public:
-  ThreadPool() : tasks_(INT_MAX), shutted_(false) {
-    for (size_t i = 0; i < default_num_workers(); ++i) {
-      workers_.emplace_back(thread_initialization, this);
-    }
-  }
+  ThreadPool() : ThreadPool(ThreadPoolOptions()) {}
   
+  // Fixed number of workers.
   explicit ThreadPool(const size_t num_threads)
-      : tasks_(INT_MAX),
+      : ThreadPool(ThreadPoolOptions{num_threads, num_threads}) {}
+  
+  explicit ThreadPool(const ThreadPoolOptions& options)
+      : options_(options),
+        tasks_(INT_MAX),
         shutted_(false) {
-    for (size_t i = 0; i < num_threads; ++i) {
-      workers_.emplace_back(thread_initialization, this);
+    options_.max_workers = std::max(options_.max_workers, options_.min_workers);
+    std::unique_lock<std::mutex> lock(workers_mtx_);
+    for (size_t i = 0; i < options_.min_workers; ++i) {
+      SpawnWorker();
     }
   }
   
@@ -111,37 +155,363 @@ class ThreadPool {
     }
   }
   
-  std::future<T> Submit(std::function<T()> task) {
-    std::packaged_task<T()> p_task(task);
-    std::future<T> future = p_task.get_future();
+  template <class F, class... Args,
+            class = typename std::enable_if<std::is_invocable<F, Args...>::value>::type>
+  auto Submit(F&& f, Args&&... args) {
+    return SubmitWithPriority(TaskPriority::kNormal, std::forward<F>(f), std::forward<Args>(args)...);
+  }
+  
+  std::future<T> Submit(std::function<T()> task, const TaskPriority priority = TaskPriority::kNormal) {
+    return SubmitWithPriority(priority, std::move(task));
+  }
+  
+  template <class F, class... Args>
+  auto SubmitWithPriority(const TaskPriority priority, F&& f, Args&&... args) {
+    return Enqueue(MakeTask(std::forward<F>(f), std::forward<Args>(args)...),
+                   [this, priority](Task&& task) {
+                     tasks_.Put(std::move(task), priority);
+                     MaybeSpawnWorker();
+                   });
+  }
+  
+  template <class F, class... Args>
+  auto Async(F&& f, Args&&... args) {
+    auto callable = MakeCallable(std::forward<F>(f), std::forward<Args>(args)...);
+    using R = decltype(callable());
+    Promise<R> promise(this);
+    Future<R> future = promise.GetFuture();
+    Execute(Task([promise = std::move(promise), callable = std::move(callable)]() mutable {
+      try {
+        if constexpr (std::is_void<R>::value) {
+          callable();
+          promise.SetValue();
+        } else {
+          promise.SetValue(callable());
+        }
+      } catch (...) {
+        promise.SetException(std::current_exception());
+      }
+    }));
+    return future;
+  }
+  
+  void Execute(Task task) override {
     if (shutted_) {
       throw std::exception();
     }
-    tasks_.Put(std::move(p_task));
-    return future;
+    tasks_.Put(std::move(task));
+    MaybeSpawnWorker();
+  }
+  
+  // A helping thread waits in the task queue like an idle worker, so a new task
+  // wakes it up the same way. If it is a worker, it is not counted as idle:
+  // it is busy with the task that waits.
+  // Tasks run here are recorded into the metrics like the ones run by the loop
+  // of a worker: a worker of this pool records them into its own block,
+  // other threads share one block under metrics_mtx_.
+  void HelpUntil(const std::function<bool()>& done) override {
+    helpers_.fetch_add(1);
+    Task task;
+    Clock::time_point enqueued;
+    Clock::time_point* const enqueued_ptr = kMetrics ? &enqueued : nullptr;
+    while (tasks_.GetUnless(task, done, enqueued_ptr)) {
+      if constexpr (kMetrics) {
+        if (Executor::Current() == this) {
+          RunTask(task, enqueued, WorkerMetrics::Local());
+        } else {
+          const bool sampled = enqueued != Clock::time_point();
+          const Clock::time_point started = sampled ? Clock::now() : Clock::time_point();
+          task();
+          const Clock::time_point finished = sampled ? Clock::now() : Clock::time_point();
+          std::unique_lock<std::mutex> lock(metrics_mtx_);
+          if (sampled) {
+            helper_metrics_.Record(enqueued, started, finished);
+          } else {
+            helper_metrics_.CountTask();
+          }
+        }
+      } else {
+        task();
+      }
+    }
+    helpers_.fetch_sub(1);
+  }
+  
+  // helpers_ is seq_cst: either the helper sees done() true before it sleeps,
+  // or we see the helper here.
+  void WakeHelpers() override {
+    if (helpers_.load() != 0) {
+      tasks_.WakeAll();
+    }
+  }
+  
+  // A task with a deadline waits behind the prioritized tasks until the deadline
+  // is near, then goes before them; see PriorityBlockingQueue.
+  std::future<T> SubmitWithDeadline(std::function<T()> task,
+                                    const std::chrono::steady_clock::time_point deadline) {
+    return Enqueue(MakeTask(std::move(task)),
+                   [this, deadline](Task&& task) {
+                     tasks_.PutWithDeadline(std::move(task), deadline);
+                     MaybeSpawnWorker();
+                   });
+  }
+  
+  // Tells the pool that the current task is going to block (e.g. on I/O).
+  // While the region lasts, the worker doesn't count as runnable, and
+  // the pool spawns a replacement if fewer than min_workers remain runnable.
+  class BlockingRegion {
+   public:
+    explicit BlockingRegion(ThreadPool& pool) : pool_(pool) {
+      pool_.blocked_workers_.fetch_add(1);
+      pool_.MaybeSpawnWorker();
+    }
+    
+    ~BlockingRegion() {
+      pool_.blocked_workers_.fetch_sub(1);
+    }
+    
+    BlockingRegion(const BlockingRegion&) = delete;
+    BlockingRegion& operator=(const BlockingRegion&) = delete;
+    
+   private:
+    ThreadPool& pool_;
+  };
+  
+  size_t NumWorkers() const {
+    return live_workers_.load();
+  }
+  
+  // Number of queued tasks; unlike Stats(), it doesn't merge any metrics.
+  size_t NumPendingTasks() const {
+    return tasks_.Size();
+  }
+  
+  // Snapshot of the pool state. Per-worker counters and histograms are filled
+  // only with kMetrics, and the histograms hold a sample of the tasks (see
+  // kMetricsSamplePeriod); every worker records them
+  // into its own thread-local block, and Stats() merely reads those blocks.
+  ThreadPoolStats Stats() {
+    ThreadPoolStats stats;
+    stats.num_workers = NumWorkers();
+    stats.queue_depth = tasks_.Size();
+    if constexpr (kMetrics) {
+      std::unique_lock<std::mutex> lock(metrics_mtx_);
+      for (const auto& worker: worker_metrics_) {
+        stats.workers.push_back(worker.second->Snapshot());
+      }
+      stats.retired = retired_stats_;
+      stats.helpers = helper_metrics_.Snapshot();
+    }
+    return stats;
   }
   
   void Shutdown() {
-    shutted_ = true;
+    // Nobody spawns or retires workers after shutted_ is set: both check it
+    // under the mutex. So the threads taken here are all there are.
+    std::vector<std::thread> threads;
+    {
+      std::unique_lock<std::mutex> lock(workers_mtx_);
+      shutted_ = true;
+      for (auto& worker: workers_) {
+        threads.push_back(std::move(worker.second));
+      }
+      workers_.clear();
+      if (retired_.joinable()) {
+        threads.push_back(std::move(retired_));
+      }
+    }
     tasks_.Shutdown();
-    for(std::thread &worker: workers_) {
+    for(std::thread &worker: threads) {
       worker.join();
     }
   }
   
  private:
-  size_t default_num_workers() {
-    return std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 10;
+  using Clock = std::chrono::steady_clock;
+  
+  // A callable together with its result promise.
+  template <class R, class Callable>
+  struct PromisedTask {
+    std::promise<R> promise_;
+    Callable callable_;
+    
+    std::future<R> GetFuture() {
+      return promise_.get_future();
+    }
+    
+    void operator()() {
+      try {
+        SetValue(std::is_void<R>());
+      } catch (...) {
+        promise_.set_exception(std::current_exception());
+      }
+    }
+    
+    void SetValue(std::true_type) {
+      callable_();
+      promise_.set_value();
+    }
+    
+    void SetValue(std::false_type) {
+      promise_.set_value(callable_());
+    }
+  };
+  
+  template <class F, class... Args>
+  static auto MakeCallable(F&& f, Args&&... args) {
+    return [f = std::forward<F>(f),
+            arguments = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+      return std::apply(f, std::move(arguments));
+    };
+  }
+  
+  template <class F, class... Args>
+  static auto MakeTask(F&& f, Args&&... args) {
+    auto callable = MakeCallable(std::forward<F>(f), std::forward<Args>(args)...);
+    using R = decltype(callable());
+    return PromisedTask<R, decltype(callable)>{
+        std::promise<R>(std::allocator_arg, PoolAllocator<R>()), std::move(callable)};
   }
   
-  static void thread_initialization(ThreadPool* me) {
-    std::packaged_task<T()> task;
-    while (me->tasks_.Get(task)) {
+  template <class Promised, class Put>
+  auto Enqueue(Promised&& promised, Put put) {
+    auto future = promised.GetFuture();
+    if (shutted_) {
+      throw std::exception();
+    }
+    put(Task(std::move(promised)));
+    return future;
+  }
+  
+  // Must be called with workers_mtx_ held.
+  void SpawnWorker() {
+    const size_t index = next_worker_index_++;
+    live_workers_.fetch_add(1);
+    workers_.emplace(index, std::thread(thread_initialization, this, index));
+  }
+  
+  // A new worker is needed if blocking tasks left less than min_workers
+  // runnable workers, or if there are more queued tasks than idle workers.
+  bool NeedsWorker() const {
+    const size_t live = live_workers_.load();
+    if (live >= options_.max_workers) {
+      return false;
+    }
+    const size_t runnable = live - std::min(live, blocked_workers_.load());
+    return runnable < options_.min_workers || tasks_.Size() > idle_workers_.load();
+  }
+  
+  // Called on every submit: the mutex is taken only when a worker is needed.
+  void MaybeSpawnWorker() {
+    if (!NeedsWorker()) {
+      return;
+    }
+    std::unique_lock<std::mutex> lock(workers_mtx_);
+    if (!shutted_ && NeedsWorker()) {
+      SpawnWorker();
+    }
+  }
+  
+  // Called by a worker that has been idle for idle_timeout. The worker leaves
+  // its thread in retired_ and joins the one it replaces there, so submitters
+  // never join threads and at most one exited thread waits for Shutdown().
+  bool TryRetire(const size_t index) {
+    std::thread previous;
+    {
+      std::unique_lock<std::mutex> lock(workers_mtx_);
+      if (shutted_ || live_workers_.load() <= options_.min_workers) {
+        return false;
+      }
+      live_workers_.fetch_sub(1);
+      auto worker = workers_.find(index);
+      previous = std::move(retired_);
+      retired_ = std::move(worker->second);
+      workers_.erase(worker);
+    }
+    if (previous.joinable()) {
+      previous.join();
+    }
+    return true;
+  }
+  
+  void PinToCpu(const size_t index) {
+#ifdef __linux__
+    const size_t num_cpus = ThreadPoolOptions::DefaultNumWorkers();
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(index % num_cpus, &cpu_set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#endif
+  }
+  
+  // Only the sampled tasks have an enqueue time, and only they are timed.
+  static void RunTask(Task& task, const Clock::time_point enqueued, WorkerMetrics& metrics) {
+    if (enqueued == Clock::time_point()) {
       task();
+      metrics.CountTask();
+      return;
+    }
+    const Clock::time_point started = Clock::now();
+    task();
+    metrics.Record(enqueued, started, Clock::now());
+  }
+  
+  static void thread_initialization(ThreadPool* me, const size_t index) {
+    Executor::Current() = me;
+    if (me->options_.pin_to_cpus) {
+      me->PinToCpu(index);
+    }
+    WorkerMetrics* metrics = nullptr;
+    if constexpr (kMetrics) {
+      metrics = &WorkerMetrics::Local();
+      std::unique_lock<std::mutex> lock(me->metrics_mtx_);
+      me->worker_metrics_.emplace(index, metrics);
+    }
+    const bool elastic = me->options_.max_workers > me->options_.min_workers;
+    Task task;
+    Clock::time_point enqueued;
+    Clock::time_point* const enqueued_ptr = kMetrics ? &enqueued : nullptr;
+    while (true) {
+      me->idle_workers_.fetch_add(1);
+      const bool got = elastic ? me->tasks_.GetFor(task, me->options_.idle_timeout, enqueued_ptr)
+                               : me->tasks_.Get(task, enqueued_ptr);
+      me->idle_workers_.fetch_sub(1);
+      if (got) {
+        if constexpr (kMetrics) {
+          RunTask(task, enqueued, *metrics);
+        } else {
+          task();
+        }
+      } else if (me->shutted_ || me->TryRetire(index)) {
+        break;
+      }
+    }
+    if constexpr (kMetrics) {
+      std::unique_lock<std::mutex> lock(me->metrics_mtx_);
+      me->retired_stats_.Merge(metrics->Snapshot());
+      me->worker_metrics_.erase(index);
     }
   }
   
-  BlockingQueue<std::packaged_task<T()>> tasks_;
-  std::vector<std::thread> workers_;
-  bool shutted_;
+  ThreadPoolOptions options_;
+  // Enqueue times are taken only for the sampled tasks of the metrics.
+  PriorityBlockingQueue<Task, kMetrics ? kMetricsSamplePeriod : 0> tasks_;
+  std::mutex workers_mtx_;
+  std::unordered_map<size_t, std::thread> workers_;
+  // Thread of the last retired worker; the next one to retire joins it.
+  std::thread retired_;
+  size_t next_worker_index_{0};
+  std::atomic<size_t> live_workers_{0};
+  std::atomic<size_t> idle_workers_{0};
+  std::atomic<size_t> blocked_workers_{0};
+  // Threads in HelpUntil().
+  std::atomic<size_t> helpers_{0};
+  // Written under workers_mtx_, read without it where a stale value is harmless.
+  std::atomic<bool> shutted_;
+  std::mutex metrics_mtx_;
+  // Thread-local metrics of the live workers, by worker index.
+  std::unordered_map<size_t, WorkerMetrics*> worker_metrics_;
+  WorkerStats retired_stats_;
+  // Tasks run in HelpUntil() by threads that are not workers of this pool.
+  WorkerMetrics helper_metrics_;
 };
@@ -0,0 +1,132 @@
+//
+//  task.h
+//  Thread_pool
+//
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Move-only type-erased void() callable.
+// Callables up to kInlineSize bytes (that can be moved without exceptions)
+// are stored right inside the Task, larger ones are allocated on the heap.
+// Unlike std::function it doesn't require the callable to be copyable,
+// so it can hold a lambda owning a std::promise.
+class Task {
+ public:
+  static constexpr size_t kInlineSize = 64;
+  
+  Task() = default;
+  
+  template <class F,
+            class = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+  Task(F&& callable) {
+    using Callable = typename std::decay<F>::type;
+    if constexpr (FitsInline<Callable>()) {
+      new (&storage_) Callable(std::forward<F>(callable));
+      ops_ = &InlineOps<Callable>::kOps;
+    } else {
+      new (&storage_) Callable*(new Callable(std::forward<F>(callable)));
+      ops_ = &HeapOps<Callable>::kOps;
+    }
+  }
+  
+  Task(Task&& other) noexcept {
+    MoveFrom(other);
+  }
+  
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+  
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  
+  ~Task() {
+    Reset();
+  }
+  
+  void operator()() {
+    ops_->invoke_(&storage_);
+  }
+  
+  explicit operator bool() const {
+    return ops_ != nullptr;
+  }
+  
+ private:
+  struct Ops {
+    void (*invoke_)(void* storage);
+    // Moves the callable to the uninitialized destination and destroys the source.
+    void (*relocate_)(void* from, void* to);
+    void (*destroy_)(void* storage);
+  };
+  
+  template <class Callable>
+  static constexpr bool FitsInline() {
+    return sizeof(Callable) <= kInlineSize &&
+           alignof(Callable) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<Callable>::value;
+  }
+  
+  template <class Callable>
+  struct InlineOps {
+    static void Invoke(void* storage) {
+      (*static_cast<Callable*>(storage))();
+    }
+    
+    static void Relocate(void* from, void* to) {
+      new (to) Callable(std::move(*static_cast<Callable*>(from)));
+      static_cast<Callable*>(from)->~Callable();
+    }
+    
+    static void Destroy(void* storage) {
+      static_cast<Callable*>(storage)->~Callable();
+    }
+    
+    static constexpr Ops kOps{&Invoke, &Relocate, &Destroy};
+  };
+  
+  // The storage holds a pointer to the callable.
+  template <class Callable>
+  struct HeapOps {
+    static void Invoke(void* storage) {
+      (**static_cast<Callable**>(storage))();
+    }
+    
+    static void Relocate(void* from, void* to) {
+      new (to) Callable*(*static_cast<Callable**>(from));
+    }
+    
+    static void Destroy(void* storage) {
+      delete *static_cast<Callable**>(storage);
+    }
+    
+    static constexpr Ops kOps{&Invoke, &Relocate, &Destroy};
+  };
+  
+  void MoveFrom(Task& other) {
+    if (other.ops_ != nullptr) {
+      other.ops_->relocate_(&other.storage_, &storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+  
+  void Reset() {
+    if (ops_ != nullptr) {
+      ops_->destroy_(&storage_);
+      ops_ = nullptr;
+    }
+  }
+  
+  typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type storage_;
+  const Ops* ops_{nullptr};
+};
@@ -10,6 +10,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <condition_variable>
 #include <forward_list>
 #include <functional>
 #include <mutex>
@@ -67,7 +68,9 @@ class RWlock {
   std::condition_variable room_empty_;
 };
 
-template <typename T, class Hash = std::hash<T>>
+// SharedMutex is the type of the stripes: lock()/unlock() for writers,
+// lock_shared()/unlock_shared() for readers.
+template <typename T, class Hash = std::hash<T>, class SharedMutex = RWlock>
 class StripedHashSet {
  public:
   explicit StripedHashSet(const size_t concurrency_level,
@@ -84,7 +87,7 @@ class StripedHashSet {
   // in this case, we free the stripe and call Extend() - the method that extends the table.
   bool Insert(const T& element) {
     const size_t hash_value = hash_(element);
-    std::unique_lock<RWlock> lock(stripes_[GetStripeIndex(hash_value)]);
+    std::unique_lock<SharedMutex> lock(stripes_[GetStripeIndex(hash_value)]);
     size_t idx = GetBucketIndex(hash_value);
     if (std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end()) {
       return false;
@@ -102,7 +105,7 @@ class StripedHashSet {
   // In order to remove an element, we should lock its stripe and only then work with its bucket.
   bool Remove(const T& element) {
     const size_t hash_value = hash_(element);
-    std::unique_lock<RWlock> lock(stripes_[GetStripeIndex(hash_value)]);
+    std::unique_lock<SharedMutex> lock(stripes_[GetStripeIndex(hash_value)]);
     size_t idx = GetBucketIndex(hash_value);
     if (std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end()) {
       buckets_[idx].remove(element);
@@ -117,7 +120,7 @@ class StripedHashSet {
   // that potentially contains the element.
   bool Contains(const T& element) {
     const size_t hash_value = hash_(element);
-    std::shared_lock<RWlock> lock(stripes_[GetStripeIndex(hash_value)]);
+    std::shared_lock<SharedMutex> lock(stripes_[GetStripeIndex(hash_value)]);
     size_t idx = GetBucketIndex(hash_value);
     return std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end();
   }
@@ -138,7 +141,7 @@ class StripedHashSet {
   // In order to extend the table, we should lock all stripes,
   // but at the first we need to check if anyone has already extended the table.
   void Extend() {
-    std::vector<std::unique_lock<RWlock>> locks;
+    std::vector<std::unique_lock<SharedMutex>> locks;
     // It is enough to lock only the first stripe in order to check
     // if anyone has already extended the table.
     locks.emplace_back(stripes_[0]);
@@ -165,7 +168,7 @@ class StripedHashSet {
   const size_t growth_factor_;
   const double max_load_factor_;
   std::vector<std::forward_list<T>> buckets_;
-  std::vector<RWlock> stripes_;
+  std::vector<SharedMutex> stripes_;
   Hash hash_;
 };
 
@@ -8,38 +8,54 @@
 
 #pragma once
 
+#include "../common/hash_bits.h"
+#include "../common/sharded_counter.h"
+
 #include <algorithm>
 #include <atomic>
+#include <cstdint>
 #include <forward_list>
 #include <functional>
 #include <mutex>
 #include <vector>
 
-template <typename T, class Hash = std::hash<T>>
+// Mutex is the type of the stripes; it only needs lock() and unlock().
+// Counter counts the elements (see common/sharded_counter.h).
+//
+// The numbers of stripes and buckets are powers of two, and both indices
+// are the top bits of the mixed hash, so a bucket always belongs to one stripe
+// (the table never has fewer buckets than stripes) and no division is needed.
+// Every entry keeps its hash: lookups compare hashes before elements,
+// and Extend() moves the nodes to their new buckets without hashing again.
+template <typename T, class Hash = std::hash<T>, class Mutex = std::mutex, class Counter = ShardedCounter>
 class StripedHashSet {
  public:
+  // growth_factor is rounded up to a power of two.
   explicit StripedHashSet(const size_t concurrency_level,
                           const size_t growth_factor = 3,
                           const double max_load_factor = 0.75)
-      : size_(0),
-        growth_factor_(growth_factor),
+      : growth_shift_(Log2(RoundUpToPowerOfTwo(std::max<size_t>(2, growth_factor)))),
         max_load_factor_(max_load_factor),
-        buckets_(20),
-        stripes_(concurrency_level) {}
+        stripes_(RoundUpToPowerOfTwo(concurrency_level)),
+        stripe_shift_(IndexShift(stripes_.size())) {
+    ResetBuckets(std::max<size_t>(32, stripes_.size()));
+  }
   
   // In order to insert an element, we should lock its stripe and only then work with its bucket.
   // After insertion the table may need extension:
   // in this case, we free the stripe and call Extend() - the method that extends the table.
   bool Insert(const T& element) {
-    const size_t hash_value = hash_(element);
-    std::unique_lock<std::mutex> lock(stripes_[GetStripeIndex(hash_value)]);
-    size_t idx = GetBucketIndex(hash_value);
-    if (std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end()) {
+    const uint64_t hash_value = HashOf(element);
+    std::unique_lock<Mutex> lock(stripes_[GetStripeIndex(hash_value)]);
+    Bucket& bucket = buckets_[GetBucketIndex(hash_value)];
+    if (Find(bucket, hash_value, element) != bucket.end()) {
       return false;
     } else {
-      buckets_[idx].emplace_front(element);
-      size_.fetch_add(1);
-      if (size_.load() / buckets_.size() > max_load_factor_) {
+      bucket.push_front({hash_value, element});
+      size_.Add(1);
+      // The approximate size is enough to notice that the table is due to grow;
+      // Extend() checks the exact one.
+      if (size_.Approximate() > buckets_.size() * max_load_factor_) {
         lock.unlock();
         Extend();
       }
@@ -49,71 +65,120 @@ class StripedHashSet {
   
   // In order to remove an element, we should lock its stripe and only then work with its bucket.
   bool Remove(const T& element) {
-    const size_t hash_value = hash_(element);
-    std::unique_lock<std::mutex> lock(stripes_[GetStripeIndex(hash_value)]);
-    size_t idx = GetBucketIndex(hash_value);
-    if (std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end()) {
-      buckets_[idx].remove(element);
-      size_.fetch_sub(1);
-      return true;
-    } else {
-      return false;
+    const uint64_t hash_value = HashOf(element);
+    std::unique_lock<Mutex> lock(stripes_[GetStripeIndex(hash_value)]);
+    Bucket& bucket = buckets_[GetBucketIndex(hash_value)];
+    for (auto prev = bucket.before_begin(), it = bucket.begin(); it != bucket.end(); prev = it++) {
+      if (it->hash_ == hash_value && it->element_ == element) {
+        bucket.erase_after(prev);
+        size_.Add(-1);
+        return true;
+      }
     }
+    return false;
   }
   
   // Firstly we should lock the necessary stripe and only then work with the bucket
   // that potentially contains the element.
   bool Contains(const T& element) {
-    const size_t hash_value = hash_(element);
-    std::unique_lock<std::mutex> lock(stripes_[GetStripeIndex(hash_value)]);
-    size_t idx = GetBucketIndex(hash_value);
-    return std::find(buckets_[idx].begin(), buckets_[idx].end(), element) != buckets_[idx].end();
+    const uint64_t hash_value = HashOf(element);
+    std::unique_lock<Mutex> lock(stripes_[GetStripeIndex(hash_value)]);
+    Bucket& bucket = buckets_[GetBucketIndex(hash_value)];
+    return Find(bucket, hash_value, element) != bucket.end();
   }
   
   size_t Size() const {
-    return size_.load();
+    return size_.Sum();
+  }
+  
+  size_t BucketCount() const {
+    return buckets_.size();
   }
   
  private:
-  size_t GetBucketIndex(const size_t hash_value) {
-    return hash_value % buckets_.size();
+  struct Entry {
+    uint64_t hash_;
+    T element_;
+  };
+  
+  using Bucket = std::forward_list<Entry>;
+  
+  static size_t Log2(const size_t power_of_two) {
+    size_t log = 0;
+    while ((size_t(1) << log) < power_of_two) {
+      ++log;
+    }
+    return log;
+  }
+  
+  // Shift that maps a 64-bit hash to its top log2(size) bits.
+  static size_t IndexShift(const size_t size) {
+    return 64 - Log2(size);
+  }
+  
+  static size_t IndexOf(const uint64_t hash_value, const size_t shift) {
+    // A shift by 64 is undefined, and a table of one slot has index 0 only.
+    return shift == 64 ? 0 : static_cast<size_t>(hash_value >> shift);
+  }
+  
+  // The indices are the top bits of this.
+  uint64_t HashOf(const T& element) const {
+    return MixBits(static_cast<uint64_t>(hash_(element)));
+  }
+  
+  static typename Bucket::iterator Find(Bucket& bucket, const uint64_t hash_value, const T& element) {
+    return std::find_if(bucket.begin(), bucket.end(), [hash_value, &element](const Entry& entry) {
+      return entry.hash_ == hash_value && entry.element_ == element;
+    });
+  }
+  
+  size_t GetBucketIndex(const uint64_t hash_value) const {
+    return IndexOf(hash_value, bucket_shift_);
+  }
+  
+  size_t GetStripeIndex(const uint64_t hash_value) const {
+    return IndexOf(hash_value, stripe_shift_);
   }
   
-  size_t GetStripeIndex(const size_t hash_value) {
-    return hash_value % stripes_.size();
+  void ResetBuckets(const size_t count) {
+    buckets_ = std::vector<Bucket>(count);
+    bucket_shift_ = IndexShift(count);
   }
   
   // In order to extend the table, we should lock all stripes,
   // but at the first we need to check if anyone has already extended the table.
   void Extend() {
-    std::vector<std::unique_lock<std::mutex>> locks;
+    std::vector<std::unique_lock<Mutex>> locks;
     // It is enough to lock only the first stripe in order to check
     // if anyone has already extended the table.
     locks.emplace_back(stripes_[0]);
-    if (size_.load() / buckets_.size() > max_load_factor_) {
+    if (size_.Sum() > buckets_.size() * max_load_factor_) {
       // We should lock stripes in order (e.g., from first one to the last one),
       // otherwise a deadlock may happen.
       for (size_t i = 1; i < stripes_.size(); ++i) {
         locks.emplace_back(stripes_[i]);
       }
-      // When all stripes are locked, we extend the table.
-      std::vector<std::forward_list<T>> new_buckets(buckets_.size() * growth_factor_);
-      for (auto& bucket: buckets_) {
-        for (auto& element: bucket) {
-          size_t hash_value = hash_(element);
-          size_t b = hash_value % new_buckets.size();
-          new_buckets[b].push_front(element);
+      // When all stripes are locked, we extend the table: nodes are spliced
+      // into their new buckets by their stored hashes, nothing is copied.
+      std::vector<Bucket> old_buckets;
+      old_buckets.swap(buckets_);
+      ResetBuckets(old_buckets.size() << growth_shift_);
+      for (Bucket& bucket: old_buckets) {
+        while (!bucket.empty()) {
+          Bucket& target = buckets_[GetBucketIndex(bucket.front().hash_)];
+          target.splice_after(target.before_begin(), bucket, bucket.before_begin());
         }
       }
-      buckets_.swap(new_buckets);
     }
   }
   
-  std::atomic<size_t> size_;
-  const size_t growth_factor_;
+  Counter size_;
+  const size_t growth_shift_;
   const double max_load_factor_;
-  std::vector<std::forward_list<T>> buckets_;
-  std::vector<std::mutex> stripes_;
+  std::vector<Bucket> buckets_;
+  size_t bucket_shift_;
+  std::vector<Mutex> stripes_;
+  const size_t stripe_shift_;
   Hash hash_;
 };
 
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "arena_allocator.h"
+#include "../common/sharded_counter.h"
 
 #include <atomic>
 #include <limits>
@@ -47,13 +48,15 @@ class SpinLock {
 ///////////////////////////////////////////////////////////////////////
 
 // Singly-linked Concurrent Sorted List with Optimstic Locking.
-template <typename T>
+// Lock is the type of the per-node locks; it needs Lock() and Unlock().
+// Counter counts the elements (see common/sharded_counter.h).
+template <typename T, class Lock = SpinLock, class Counter = ShardedCounter>
 class OptimisticLinkedSet {
  private:
   struct Node {
     T element_;
     std::atomic<Node*> next_;
-    SpinLock lock_{};
+    Lock lock_{};
     std::atomic<bool> marked_{false};
     
     Node(const T& element, Node* next = nullptr)
@@ -100,7 +103,7 @@ class OptimisticLinkedSet {
       Node* inserted_element = allocator_.New<Node>(element);
       inserted_element->next_.store(edge.curr_);
       edge.pred_->next_.store(inserted_element);
-      size_.fetch_add(1);
+      size_.Add(1);
       edge.pred_->lock_.Unlock();
       return true;
     }
@@ -133,7 +136,7 @@ class OptimisticLinkedSet {
     } else {
       edge.curr_->marked_.store(true);
       edge.pred_->next_.store(edge.curr_->next_.load());
-      size_.fetch_sub(1);
+      size_.Add(-1);
       edge.pred_->lock_.Unlock();
       edge.curr_->lock_.Unlock();
       return true;
@@ -147,7 +150,7 @@ class OptimisticLinkedSet {
   }
   
   size_t Size() const {
-    return size_.load();
+    return size_.Sum();
   }
   
  private:
@@ -182,7 +185,7 @@ class OptimisticLinkedSet {
  private:
   ArenaAllocator& allocator_;
   Node* head_{nullptr};
-  std::atomic<size_t> size_{0};
+  Counter size_;
 };
 
 template <typename T> using ConcurrentSet = OptimisticLinkedSet<T>;
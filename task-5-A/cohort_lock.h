@@ -0,0 +1,151 @@
+//
+//  cohort_lock.h
+//  MCS_spinlock
+//
+
+#pragma once
+
+#include "numa_topology.h"
+#include "spinlock_pause.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// NUMA-aware cohort lock (Dice, Marathe, Shavit).
+// Every NUMA node has its own MCS queue, and one global ticket lock
+// is shared by all nodes. The first thread of a node takes the global lock,
+// then ownership is passed along the local queue (the global lock stays
+// held by the node) until the queue runs out or batch_limit local handoffs
+// happen in a row. Only then the global lock is released, so the lock and
+// the data it protects migrate between sockets at most once per batch.
+//
+// usage:
+// {
+// CohortLock::Guard guard(lock); // lock acquired
+// ... // in critical section
+// } // lock released
+//
+
+///////////////////////////////////////////////////////////////////////
+
+class CohortLock {
+ private:
+  struct Cohort;
+
+ public:
+  static constexpr size_t kDefaultBatchLimit = 64;
+
+  explicit CohortLock(const NumaTopology& topology = NumaTopology::Discover(),
+                      const size_t batch_limit = kDefaultBatchLimit)
+      : topology_(topology),
+        batch_limit_(batch_limit),
+        cohorts_(topology_.NumNodes()) {}
+
+  CohortLock(const CohortLock&) = delete;
+  CohortLock& operator=(const CohortLock&) = delete;
+
+  class Guard {
+   public:
+    explicit Guard(CohortLock& lock)
+        : lock_(lock),
+          cohort_(&lock.cohorts_[lock.topology_.CurrentNode()]) {
+      Acquire();
+    }
+
+    ~Guard() {
+      Release();
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+   private:
+    enum Status {
+      kWaiting = 0,
+      // Predecessor from the same node passed the global lock along.
+      kLocalHandoff = 1,
+      // Predecessor released the global lock, we have to take it ourselves.
+      kAcquireGlobal = 2
+    };
+
+    // The cohort is remembered at construction time:
+    // the thread may migrate to another node while holding the lock.
+    void Acquire() {
+      Guard* prev_tail = cohort_->wait_queue_tail_.exchange(this, std::memory_order_acq_rel);
+      if (prev_tail != nullptr) {
+        prev_tail->next_.store(this, std::memory_order_release);
+        int status;
+        while ((status = status_.load(std::memory_order_acquire)) == kWaiting) {
+          SpinLockPause();
+        }
+        if (status == kLocalHandoff) {
+          return;
+        }
+      }
+      lock_.AcquireGlobal();
+      cohort_->batch_count_ = 0;
+    }
+
+    // Pass the lock to the local successor while the batch lasts,
+    // otherwise release the global lock first.
+    void Release() {
+      Guard* next = next_.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        Guard* tmp = this;
+        if (cohort_->wait_queue_tail_.compare_exchange_strong(tmp, nullptr, std::memory_order_release,
+                                                              std::memory_order_relaxed)) {
+          lock_.ReleaseGlobal();
+          return;
+        }
+        while ((next = next_.load(std::memory_order_acquire)) == nullptr) {
+          SpinLockPause();
+        }
+      }
+      // batch_count_ is touched by the current owner of the cohort only.
+      if (++cohort_->batch_count_ < lock_.batch_limit_) {
+        next->status_.store(kLocalHandoff, std::memory_order_release);
+      } else {
+        lock_.ReleaseGlobal();
+        next->status_.store(kAcquireGlobal, std::memory_order_release);
+      }
+    }
+
+    CohortLock& lock_;
+    Cohort* cohort_;
+
+    std::atomic<int> status_{kWaiting};
+    std::atomic<Guard*> next_{nullptr};
+  };
+
+ private:
+  // Local MCS queue of one NUMA node, padded to its own cache line.
+  struct alignas(64) Cohort {
+    std::atomic<Guard*> wait_queue_tail_{nullptr};
+    size_t batch_count_{0};
+  };
+
+  // The global lock is released by whichever thread of the cohort holds it last,
+  // so it has to be thread-oblivious: a ticket lock is, and it is fair between nodes.
+  void AcquireGlobal() {
+    const size_t ticket = next_ticket_.fetch_add(1, std::memory_order_relaxed);
+    while (now_serving_.load(std::memory_order_acquire) != ticket) {
+      SpinLockPause();
+    }
+  }
+
+  void ReleaseGlobal() {
+    now_serving_.store(now_serving_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+
+  const NumaTopology topology_;
+  const size_t batch_limit_;
+  std::vector<Cohort> cohorts_;
+
+  alignas(64) std::atomic<size_t> next_ticket_{0};
+  alignas(64) std::atomic<size_t> now_serving_{0};
+};
+
+///////////////////////////////////////////////////////////////////////
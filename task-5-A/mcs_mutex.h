@@ -0,0 +1,119 @@
+//
+//  mcs_mutex.h
+//  MCS_spinlock
+//
+
+#pragma once
+
+#include "../common/futex.h"
+#include "spinlock_pause.h"
+
+#include <atomic>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////
+
+// MCS queue lock that sleeps instead of spinning forever.
+// A waiter spins on its own node for a bounded number of iterations
+// and then parks on a futex in that node. The owner passes the lock
+// to its successor only, so exactly one thread is woken up per release.
+//
+// usage:
+// {
+// MCSMutex::Guard guard(mutex); // mutex acquired
+// ... // in critical section
+// } // mutex released
+//
+
+///////////////////////////////////////////////////////////////////////
+
+class MCSMutex {
+ public:
+  static const size_t kDefaultSpinBudget = 1024;
+
+  explicit MCSMutex(const size_t spin_budget = kDefaultSpinBudget)
+      : spin_budget_(spin_budget) {}
+
+  MCSMutex(const MCSMutex&) = delete;
+  MCSMutex& operator=(const MCSMutex&) = delete;
+
+  class Guard {
+   public:
+    explicit Guard(MCSMutex& mutex) : mutex_(mutex) {
+      Acquire();
+    }
+
+    ~Guard() {
+      Release();
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+   private:
+    enum State {
+      kWaiting = 0,
+      kParked = 1,
+      kOwner = 2
+    };
+
+    // Add self to the wait queue, spin for a while and then fall asleep
+    // until the predecessor hands the ownership over.
+    void Acquire() {
+      Guard* prev_tail = mutex_.wait_queue_tail_.exchange(this, std::memory_order_acq_rel);
+      if (prev_tail == nullptr) {
+        return;
+      }
+      prev_tail->next_.store(this, std::memory_order_release);
+
+      for (size_t i = 0; i < mutex_.spin_budget_; ++i) {
+        if (state_.load(std::memory_order_acquire) == kOwner) {
+          return;
+        }
+        SpinLockPause();
+      }
+
+      // If the CAS fails, the ownership has been passed in the meantime.
+      int expected = kWaiting;
+      if (state_.compare_exchange_strong(expected, kParked, std::memory_order_acquire)) {
+        while (state_.load(std::memory_order_acquire) != kOwner) {
+          FutexWait(&state_, kParked);
+        }
+      }
+    }
+
+    // Transfer ownership to the next node in the wait queue (waking it up
+    // if it is parked) or reset the tail pointer if there are no other contenders.
+    void Release() {
+      Guard* next = next_.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        Guard* tmp = this;
+        if (mutex_.wait_queue_tail_.compare_exchange_strong(tmp, nullptr, std::memory_order_release,
+                                                            std::memory_order_relaxed)) {
+          return;
+        }
+        // The successor has already swapped the tail, wait until it links itself.
+        while ((next = next_.load(std::memory_order_acquire)) == nullptr) {
+          SpinLockPause();
+        }
+      }
+      // The successor may leave and destroy its node right after the exchange,
+      // in which case the wakeup hits a dead address: it is harmless for futexes.
+      if (next->state_.exchange(kOwner, std::memory_order_release) == kParked) {
+        FutexWake(&next->state_, 1);
+      }
+    }
+
+   private:
+    MCSMutex& mutex_;
+
+    std::atomic<int> state_{kWaiting};
+    std::atomic<Guard*> next_{nullptr};
+  };
+
+ private:
+  const size_t spin_budget_;
+  std::atomic<Guard*> wait_queue_tail_{nullptr};
+};
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,143 @@
+//
+//  numa_topology.h
+//  MCS_spinlock
+//
+
+#pragma once
+
+#include <dirent.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Mapping from CPU ids to NUMA nodes.
+//
+// usage:
+// NumaTopology topology = NumaTopology::Discover(); // real nodes from sysfs
+// NumaTopology topology = NumaTopology::Simulate(2); // CPUs split into 2 ranges
+//
+
+///////////////////////////////////////////////////////////////////////
+
+class NumaTopology {
+ public:
+  // Reads /sys/devices/system/node/node<id>/cpulist for every node directory.
+  // Node ids may be sparse; they are renumbered densely in increasing order.
+  // Nodes without CPUs (memory-only) are skipped. If sysfs is not available
+  // (or lists no CPUs at all), all CPUs form one node.
+  static NumaTopology Discover() {
+    std::vector<size_t> node_ids;
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+      while (const dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            name.find_first_not_of("0123456789", 4) == std::string::npos) {
+          node_ids.push_back(std::stoul(name.substr(4)));
+        }
+      }
+      closedir(dir);
+    }
+    std::sort(node_ids.begin(), node_ids.end());
+
+    NumaTopology topology;
+    for (const size_t node_id: node_ids) {
+      std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+      std::string line;
+      if (!cpulist.is_open() || !std::getline(cpulist, line)) {
+        continue;
+      }
+      const std::vector<size_t> cpus = ParseCpuList(line);
+      if (!cpus.empty()) {
+        topology.AddNode(cpus);
+      }
+    }
+    if (topology.num_nodes_ == 0) {
+      return Simulate(1);
+    }
+    return topology;
+  }
+
+  // Splits CPUs 0..num_cpus-1 into num_nodes contiguous ranges of (almost) equal size,
+  // so that hierarchical locks can be tried out on a single-socket machine.
+  static NumaTopology Simulate(const size_t num_nodes, const size_t num_cpus = DefaultNumCpus()) {
+    NumaTopology topology;
+    const size_t nodes = num_nodes == 0 ? 1 : num_nodes;
+    for (size_t node = 0; node < nodes; ++node) {
+      std::vector<size_t> cpus;
+      for (size_t cpu = node * num_cpus / nodes; cpu < (node + 1) * num_cpus / nodes; ++cpu) {
+        cpus.push_back(cpu);
+      }
+      topology.AddNode(cpus);
+    }
+    return topology;
+  }
+
+  size_t NumNodes() const {
+    return num_nodes_;
+  }
+
+  // CPUs unknown to the topology (e.g. hotplugged later) are spread over nodes by modulo.
+  size_t NodeOfCpu(const size_t cpu) const {
+    if (cpu < node_of_cpu_.size() && node_of_cpu_[cpu] != kUnknownNode) {
+      return node_of_cpu_[cpu];
+    }
+    return cpu % num_nodes_;
+  }
+
+  // Node of the CPU the calling thread is running on right now.
+  size_t CurrentNode() const {
+    const int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : NodeOfCpu(static_cast<size_t>(cpu));
+  }
+
+ private:
+  static constexpr size_t kUnknownNode = static_cast<size_t>(-1);
+
+  NumaTopology() : num_nodes_(0) {}
+
+  static size_t DefaultNumCpus() {
+    return std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+  }
+
+  // Parses lists like "0-3,8-11" into {0, 1, 2, 3, 8, 9, 10, 11}.
+  static std::vector<size_t> ParseCpuList(const std::string& line) {
+    std::vector<size_t> cpus;
+    std::stringstream stream(line);
+    std::string range;
+    while (std::getline(stream, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+      const size_t dash = range.find('-');
+      const size_t first = std::stoul(range.substr(0, dash));
+      const size_t last = dash == std::string::npos ? first : std::stoul(range.substr(dash + 1));
+      for (size_t cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+    return cpus;
+  }
+
+  void AddNode(const std::vector<size_t>& cpus) {
+    for (size_t cpu: cpus) {
+      if (cpu >= node_of_cpu_.size()) {
+        node_of_cpu_.resize(cpu + 1, kUnknownNode);
+      }
+      node_of_cpu_[cpu] = num_nodes_;
+    }
+    ++num_nodes_;
+  }
+
+  std::vector<size_t> node_of_cpu_;
+  size_t num_nodes_;
+};
+
+///////////////////////////////////////////////////////////////////////
@@ -0,0 +1,215 @@
+//
+//  timeout_mcs_lock.h
+//  MCS_spinlock
+//
+
+#pragma once
+
+#include "spinlock_pause.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+///////////////////////////////////////////////////////////////////////
+
+// MCS lock with abortable acquisition (in the spirit of Scott's MCS-TP).
+// A waiter that runs out of time marks its queue node as aborted and leaves;
+// the node stays in the queue, and the next releaser skips it and frees it.
+// So the chain is never broken and the leaving thread doesn't have to wait
+// for its neighbours.
+//
+// usage:
+// if (lock.TryAcquireFor(std::chrono::milliseconds(10))) {
+//   ... // in critical section
+//   lock.Release();
+// }
+//
+// {
+// TimeoutMCSLock::Guard guard(lock); // unconditional acquisition
+// ... // in critical section
+// } // lock released
+//
+
+///////////////////////////////////////////////////////////////////////
+
+class TimeoutMCSLock {
+ public:
+  TimeoutMCSLock() = default;
+
+  TimeoutMCSLock(const TimeoutMCSLock&) = delete;
+  TimeoutMCSLock& operator=(const TimeoutMCSLock&) = delete;
+
+  class Guard {
+   public:
+    explicit Guard(TimeoutMCSLock& lock) : lock_(lock) {
+      lock_.Acquire();
+    }
+
+    ~Guard() {
+      lock_.Release();
+    }
+
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+
+   private:
+    TimeoutMCSLock& lock_;
+  };
+
+  void Acquire() {
+    Node* node = NewNode();
+    if (!Enqueue(node)) {
+      while (node->state_.load(std::memory_order_acquire) != kOwner) {
+        SpinLockPause();
+      }
+    }
+    owner_node_ = node;
+  }
+
+  // Succeeds only if nobody holds or waits for the lock.
+  bool TryAcquire() {
+    if (wait_queue_tail_.load(std::memory_order_relaxed) != nullptr) {
+      return false;
+    }
+    Node* node = NewNode();
+    Node* expected = nullptr;
+    if (!wait_queue_tail_.compare_exchange_strong(expected, node, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+      FreeNode(node);
+      return false;
+    }
+    owner_node_ = node;
+    return true;
+  }
+
+  // Waits in the queue at most timeout. On failure the node is abandoned in the queue.
+  template <class Rep, class Period>
+  bool TryAcquireFor(const std::chrono::duration<Rep, Period>& timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    Node* node = NewNode();
+    if (Enqueue(node)) {
+      owner_node_ = node;
+      return true;
+    }
+    for (size_t i = 1; ; ++i) {
+      if (node->state_.load(std::memory_order_acquire) == kOwner) {
+        owner_node_ = node;
+        return true;
+      }
+      // Reading the clock is much more expensive than the pause, so we do it rarely.
+      if (i % kClockCheckPeriod == 0 && std::chrono::steady_clock::now() >= deadline) {
+        int expected = kWaiting;
+        if (node->state_.compare_exchange_strong(expected, kAborted, std::memory_order_acq_rel)) {
+          // The node now belongs to the queue: the releaser that reaches it frees it.
+          return false;
+        }
+        // The lock has been passed to us right before the abort.
+        owner_node_ = node;
+        return true;
+      }
+      SpinLockPause();
+    }
+  }
+
+  // Passes the lock to the first successor that hasn't aborted,
+  // freeing the aborted nodes on the way.
+  void Release() {
+    Node* owner = owner_node_;
+    Node* curr = owner;
+    while (true) {
+      Node* next = curr->next_.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        Node* tmp = curr;
+        if (wait_queue_tail_.compare_exchange_strong(tmp, nullptr, std::memory_order_release,
+                                                     std::memory_order_relaxed)) {
+          break;
+        }
+        // Somebody has already swapped the tail, wait until it links itself.
+        while ((next = curr->next_.load(std::memory_order_acquire)) == nullptr) {
+          SpinLockPause();
+        }
+      }
+      // Nobody refers to an aborted node once its successor is linked.
+      if (curr != owner) {
+        FreeNode(curr);
+      }
+      curr = next;
+      int expected = kWaiting;
+      if (curr->state_.compare_exchange_strong(expected, kOwner, std::memory_order_acq_rel)) {
+        FreeNode(owner);
+        return;
+      }
+    }
+    if (curr != owner) {
+      FreeNode(curr);
+    }
+    FreeNode(owner);
+  }
+
+ private:
+  static constexpr size_t kClockCheckPeriod = 64;
+
+  enum State {
+    kWaiting = 0,
+    kOwner = 1,
+    kAborted = 2
+  };
+
+  // Nodes live on the heap: an aborted node outlives the thread's attempt.
+  struct Node {
+    std::atomic<int> state_{kWaiting};
+    std::atomic<Node*> next_{nullptr};
+  };
+
+  // Returns true if the lock was free and is now owned.
+  bool Enqueue(Node* node) {
+    Node* prev_tail = wait_queue_tail_.exchange(node, std::memory_order_acq_rel);
+    if (prev_tail == nullptr) {
+      return true;
+    }
+    prev_tail->next_.store(node, std::memory_order_release);
+    return false;
+  }
+
+  // Every thread keeps one spare node, so uncontended acquisitions don't allocate.
+  struct SpareNodeHolder {
+    Node* node_{nullptr};
+
+    ~SpareNodeHolder() {
+      delete node_;
+    }
+  };
+
+  static Node*& SpareNode() {
+    static thread_local SpareNodeHolder spare;
+    return spare.node_;
+  }
+
+  static Node* NewNode() {
+    Node*& spare = SpareNode();
+    if (spare == nullptr) {
+      return new Node{};
+    }
+    Node* node = spare;
+    spare = nullptr;
+    node->state_.store(kWaiting, std::memory_order_relaxed);
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    return node;
+  }
+
+  static void FreeNode(Node* node) {
+    Node*& spare = SpareNode();
+    if (spare == nullptr) {
+      spare = node;
+    } else {
+      delete node;
+    }
+  }
+
+  std::atomic<Node*> wait_queue_tail_{nullptr};
+  // Written and read by the current owner only.
+  Node* owner_node_{nullptr};
+};
+
+///////////////////////////////////////////////////////////////////////
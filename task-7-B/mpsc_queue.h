@@ -0,0 +1,119 @@
+//
+//  mpsc_queue.h
+//  Lock_free_queue
+//
+
+#pragma once
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////
+
+// Link embedded into every message of an IntrusiveMpscQueue:
+// struct Message : MpscHook<> { ... };
+// A message may be in at most one queue at a time.
+template <template <typename U> class Atomic = std::atomic>
+struct MpscHook {
+  MpscHook() = default;
+
+  // Copies of a message are not linked anywhere, whatever the original is.
+  MpscHook(const MpscHook&) {}
+
+  MpscHook& operator=(const MpscHook&) {
+    return *this;
+  }
+
+  Atomic<MpscHook*> mpsc_next_{nullptr};
+};
+
+// Intrusive multi-producer single-consumer queue of D. Vyukov.
+//
+// Producers link messages at the head with one exchange and one store and
+// never wait for each other or for the consumer. The consumer walks the list
+// from the tail with plain loads and stores to its own pointer, no atomic
+// read-modify-write except when it takes the last message. No memory is
+// allocated: the queue owns nothing but a stub node, the caller owns
+// the messages and must keep them alive until they are popped.
+//
+// A producer preempted between its exchange and its store hides its
+// message and every message pushed after it until it resumes: Pop()
+// returns nullptr meanwhile even though the queue is not empty. So the queue
+// is not linearizable, which is fine for mailboxes, whose consumer simply
+// polls again (or is woken again by the next producer).
+//
+// usage:
+// struct Message : MpscHook<> { int payload; };
+// IntrusiveMpscQueue<Message> mailbox;
+// ... producers: mailbox.Push(&message);
+// ... consumer: while (Message* message = mailbox.Pop()) { ... }
+template <class T, template <typename U> class Atomic = std::atomic>
+class IntrusiveMpscQueue {
+  using Hook = MpscHook<Atomic>;
+
+ public:
+  IntrusiveMpscQueue()
+      : head_(&stub_),
+        tail_(&stub_) {}
+
+  IntrusiveMpscQueue(const IntrusiveMpscQueue&) = delete;
+  IntrusiveMpscQueue& operator=(const IntrusiveMpscQueue&) = delete;
+
+  // Any thread.
+  void Push(T* message) {
+    PushHook(static_cast<Hook*>(message));
+  }
+
+  // Consumer only. Returns the oldest message, or nullptr
+  // if there is none or the oldest one is still being linked.
+  T* Pop() {
+    Hook* tail = tail_;
+    Hook* next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      // Skip the stub.
+      tail_ = next;
+      tail = next;
+      next = next->mpsc_next_.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer has swung the head but not linked its message yet.
+      return nullptr;
+    }
+    // tail is the last message: put the stub behind it, so that
+    // the list never becomes empty, and take tail if nobody got in between.
+    PushHook(&stub_);
+    next = tail->mpsc_next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return static_cast<T*>(tail);
+    }
+    return nullptr;
+  }
+
+  // Consumer only. True may hide messages being linked, as with Pop().
+  bool Empty() const {
+    return tail_ == &stub_ && stub_.mpsc_next_.load(std::memory_order_acquire) == nullptr;
+  }
+
+ private:
+  void PushHook(Hook* hook) {
+    hook->mpsc_next_.store(nullptr, std::memory_order_relaxed);
+    Hook* previous = head_.exchange(hook, std::memory_order_acq_rel);
+    // From here until the store the list is broken between previous and hook.
+    previous->mpsc_next_.store(hook, std::memory_order_release);
+  }
+
+  // Producers' end: the last pushed node.
+  alignas(64) Atomic<Hook*> head_;
+  // Consumer's end: the oldest node, possibly the stub.
+  alignas(64) Hook* tail_;
+  Hook stub_;
+};
+
+///////////////////////////////////////////////////////////////////////
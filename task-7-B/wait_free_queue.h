@@ -0,0 +1,334 @@
+//
+//  wait_free_queue.h
+//  Lock_free_queue
+//
+
+#pragma once
+
+#include "../common/thread_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Wait-free MPMC queue of Kogan and Petrank.
+//
+// Every thread owns a slot in state_ with a descriptor of its current
+// operation. An operation takes a phase number larger than the phases of
+// all operations that have started before, announces itself in its slot
+// and then helps every pending operation with a phase not larger than its
+// own, in slot order, before returning. So an operation can be overtaken
+// only by operations that started before it, and it completes within
+// O(max_threads^2) steps of its own thread no matter how the others are
+// scheduled, whereas an Enqueue of LockFreeQueue may lose its CAS on the tail
+// forever.
+//
+// The list itself is the Michael-Scott one: enqueue links a node after
+// the tail and then swings the tail, dequeue swings the head. Every step that
+// completes someone's operation also records that in its descriptor,
+// so helpers don't apply an operation twice.
+//
+// Memory is reclaimed like in LockFreeQueue: removed nodes and replaced
+// descriptors are freed by the last operation to leave a quiescent period
+// (no other operation in progress); under constant load they are kept until
+// the queue is destroyed.
+//
+// Slots are indexed by ThreadIndexRegistry (common/thread_index.h), so a slot
+// is bound to a thread for the thread's lifetime and reused after it exits.
+// Threads with an index beyond max_threads share one extra slot and take
+// turns on it under a mutex: their operations are still correct, but no
+// longer wait-free.
+template <typename T, template <typename U> class Atomic = std::atomic>
+class WaitFreeQueue {
+  static const size_t kNoThread = SIZE_MAX;
+
+  struct Node {
+    T element_{};
+    Atomic<Node*> next_{nullptr};
+    // Slot of the thread whose Enqueue linked this node.
+    size_t enqueuer_{kNoThread};
+    // Slot of the thread whose Dequeue removes the node after this one.
+    Atomic<size_t> dequeuer_{kNoThread};
+
+    explicit Node(T element, const size_t enqueuer)
+        : element_(std::move(element)),
+          enqueuer_(enqueuer) {}
+
+    explicit Node() {}
+  };
+
+  // Immutable once published; a change of state is a CAS of the slot
+  // to a new descriptor.
+  struct Descriptor {
+    uint64_t phase_;
+    bool pending_;
+    bool enqueue_;
+    // Enqueue: the node to link. Dequeue: the head node at the moment
+    // of removal (the dequeued element lives in its successor),
+    // nullptr if the queue was found empty.
+    Node* node_;
+    // The descriptor this one replaced in the same slot; only
+    // the reclamation walks these chains.
+    Descriptor* replaced_{nullptr};
+  };
+
+ public:
+  explicit WaitFreeQueue(const size_t max_threads = 64)
+      : state_(max_threads + 1),
+        snapshot_(max_threads + 1) {
+    Node* dummy = new Node{};
+    head_ = dummy;
+    tail_ = dummy;
+    start_ = dummy;
+    for (Atomic<Descriptor*>& slot: state_) {
+      slot = new Descriptor{0, false, true, nullptr};
+    }
+  }
+
+  ~WaitFreeQueue() {
+    while (start_ != nullptr) {
+      Node* tmp = start_->next_.load();
+      delete start_;
+      start_ = tmp;
+    }
+    for (Atomic<Descriptor*>& slot: state_) {
+      DeleteChain(slot.load());
+    }
+  }
+
+  WaitFreeQueue(const WaitFreeQueue&) = delete;
+  WaitFreeQueue& operator=(const WaitFreeQueue&) = delete;
+
+  void Enqueue(T element) {
+    const size_t me = ThreadIndexRegistry::Current();
+    if (me >= OverflowSlot()) {
+      std::unique_lock<std::mutex> lock(overflow_mtx_);
+      EnqueueFrom(OverflowSlot(), std::move(element));
+    } else {
+      EnqueueFrom(me, std::move(element));
+    }
+  }
+
+  bool Dequeue(T& element) {
+    const size_t me = ThreadIndexRegistry::Current();
+    if (me >= OverflowSlot()) {
+      std::unique_lock<std::mutex> lock(overflow_mtx_);
+      return DequeueFrom(OverflowSlot(), element);
+    }
+    return DequeueFrom(me, element);
+  }
+
+ private:
+  // Slot shared by the threads with an index beyond max_threads.
+  size_t OverflowSlot() const {
+    return state_.size() - 1;
+  }
+
+  void EnqueueFrom(const size_t me, T element) {
+    counter_.fetch_add(1);
+    const uint64_t phase = phase_.fetch_add(1) + 1;
+    Announce(me, new Descriptor{phase, true, true, new Node(std::move(element), me)});
+    Help(phase);
+    HelpFinishEnqueue();
+    Leave();
+  }
+
+  bool DequeueFrom(const size_t me, T& element) {
+    counter_.fetch_add(1);
+    const uint64_t phase = phase_.fetch_add(1) + 1;
+    Announce(me, new Descriptor{phase, true, false, nullptr});
+    Help(phase);
+    HelpFinishDequeue();
+    Node* node = state_[me].load()->node_;
+    const bool found = node != nullptr;
+    if (found) {
+      element = node->next_.load()->element_;
+    }
+    Leave();
+    return found;
+  }
+
+  // Owner's replacement of its own (finished) descriptor.
+  void Announce(const size_t me, Descriptor* descriptor) {
+    // Exchange rather than store: a late helper of our previous operation
+    // may still replace the old descriptor, and its replacement must stay
+    // reachable for the reclamation.
+    descriptor->replaced_ = state_[me].exchange(descriptor);
+  }
+
+  // Replaces the descriptor of slot `thread`, expected to be `current`.
+  bool Replace(const size_t thread, Descriptor* current, const bool pending, Node* node) {
+    Descriptor* replacement = new Descriptor{current->phase_, pending, current->enqueue_, node, current};
+    if (state_[thread].compare_exchange_strong(current, replacement)) {
+      return true;
+    }
+    delete replacement;
+    return false;
+  }
+
+  bool IsStillPending(const size_t thread, const uint64_t phase) {
+    Descriptor* descriptor = state_[thread].load();
+    return descriptor->pending_ && descriptor->phase_ <= phase;
+  }
+
+  void Help(const uint64_t phase) {
+    // Slots at and above the bound have never been used by any thread.
+    const size_t bound = std::min(ThreadIndexRegistry::Instance().Bound(), state_.size());
+    for (size_t thread = 0; thread < bound; ++thread) {
+      Descriptor* descriptor = state_[thread].load();
+      if (descriptor->pending_ && descriptor->phase_ <= phase) {
+        if (descriptor->enqueue_) {
+          HelpEnqueue(thread, phase);
+        } else {
+          HelpDequeue(thread, phase);
+        }
+      }
+    }
+  }
+
+  void HelpEnqueue(const size_t thread, const uint64_t phase) {
+    while (IsStillPending(thread, phase)) {
+      Node* last = tail_.load();
+      Node* next = last->next_.load();
+      if (last != tail_.load()) {
+        continue;
+      }
+      if (next != nullptr) {
+        // Someone else's node is linked but the tail is behind: finish that first.
+        HelpFinishEnqueue();
+        continue;
+      }
+      if (IsStillPending(thread, phase)) {
+        Node* node = state_[thread].load()->node_;
+        if (last->next_.compare_exchange_strong(next, node)) {
+          HelpFinishEnqueue();
+          return;
+        }
+      }
+    }
+  }
+
+  // Marks the enqueue of the node after the tail as done and swings the tail.
+  void HelpFinishEnqueue() {
+    Node* last = tail_.load();
+    Node* next = last->next_.load();
+    if (next == nullptr) {
+      return;
+    }
+    const size_t thread = next->enqueuer_;
+    Descriptor* current = state_[thread].load();
+    if (last == tail_.load() && current->node_ == next) {
+      Replace(thread, current, false, next);
+    }
+    tail_.compare_exchange_strong(last, next);
+  }
+
+  void HelpDequeue(const size_t thread, const uint64_t phase) {
+    while (IsStillPending(thread, phase)) {
+      Node* first = head_.load();
+      Node* last = tail_.load();
+      Node* next = first->next_.load();
+      if (first != head_.load()) {
+        continue;
+      }
+      if (first == last) {
+        if (next == nullptr) {
+          // Empty: complete the dequeue with no node.
+          Descriptor* current = state_[thread].load();
+          if (last == tail_.load() && IsStillPending(thread, phase)) {
+            Replace(thread, current, false, nullptr);
+          }
+        } else {
+          HelpFinishEnqueue();
+        }
+        continue;
+      }
+      Descriptor* current = state_[thread].load();
+      Node* node = current->node_;
+      if (!IsStillPending(thread, phase)) {
+        break;
+      }
+      if (first == head_.load() && node != first) {
+        // Remember which head this dequeue is going to remove.
+        if (!Replace(thread, current, true, first)) {
+          continue;
+        }
+      }
+      size_t no_thread = kNoThread;
+      first->dequeuer_.compare_exchange_strong(no_thread, thread);
+      HelpFinishDequeue();
+    }
+  }
+
+  // Marks the dequeue that claimed the head as done and swings the head.
+  void HelpFinishDequeue() {
+    Node* first = head_.load();
+    Node* next = first->next_.load();
+    const size_t thread = first->dequeuer_.load();
+    if (thread == kNoThread) {
+      return;
+    }
+    Descriptor* current = state_[thread].load();
+    if (first == head_.load() && next != nullptr) {
+      Replace(thread, current, false, current->node_);
+      head_.compare_exchange_strong(first, next);
+    }
+  }
+
+  // Leaves the operation; the last one out of a quiescent period reclaims memory.
+  void Leave() {
+    if (counter_.fetch_sub(1) != 1) {
+      return;
+    }
+    bool reclaiming = false;
+    if (!reclaiming_.compare_exchange_strong(reclaiming, true)) {
+      return;
+    }
+    // An operation that started before the head and the descriptors were read
+    // and is still running may hold older nodes and descriptors; one that starts
+    // later sees neither, so they can go iff no operation is running now.
+    // The descriptors installed after the snapshot may be in use already.
+    for (size_t i = 0; i < state_.size(); ++i) {
+      snapshot_[i] = state_[i].load();
+    }
+    Node* head = head_.load();
+    if (counter_.load() == 0) {
+      while (start_ != head) {
+        Node* tmp = start_->next_.load();
+        delete start_;
+        start_ = tmp;
+      }
+      for (Descriptor* descriptor: snapshot_) {
+        DeleteChain(descriptor->replaced_);
+        descriptor->replaced_ = nullptr;
+      }
+    }
+    reclaiming_.store(false);
+  }
+
+  static void DeleteChain(Descriptor* descriptor) {
+    while (descriptor != nullptr) {
+      Descriptor* replaced = descriptor->replaced_;
+      delete descriptor;
+      descriptor = replaced;
+    }
+  }
+
+  Atomic<Node*> head_{nullptr};
+  Atomic<Node*> tail_{nullptr};
+  Node* start_{nullptr};
+  std::vector<Atomic<Descriptor*>> state_;
+  // Scratch space of the reclamation.
+  std::vector<Descriptor*> snapshot_;
+  Atomic<uint64_t> phase_{0};
+  Atomic<size_t> counter_{0};
+  Atomic<bool> reclaiming_{false};
+  std::mutex overflow_mtx_;
+};
+
+///////////////////////////////////////////////////////////////////////
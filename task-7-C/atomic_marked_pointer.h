@@ -0,0 +1,200 @@
+//
+//  atomic_marked_pointer.h
+//  Lock_free_linked_set
+//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+///////////////////////////////////////////////////////////////////////
+
+// Atomic pair (pointer, mark) packed into a single machine word.
+// Nodes are at least 2-byte aligned, so the lowest bit of the pointer
+// is always zero and can hold the mark.
+// Every operation is one load, one store or one CAS, no memory is allocated.
+template <typename T>
+class TaggedAtomicMarkedPointer {
+ public:
+  struct MarkedPointer {
+    T* ptr_;
+    bool marked_;
+  };
+
+  TaggedAtomicMarkedPointer(T* ptr = nullptr, bool marked = false)
+      : word_(Pack({ptr, marked})) {}
+
+  TaggedAtomicMarkedPointer(const TaggedAtomicMarkedPointer&) = delete;
+  TaggedAtomicMarkedPointer& operator=(const TaggedAtomicMarkedPointer&) = delete;
+
+  MarkedPointer Load() const {
+    return Unpack(word_.load(std::memory_order_acquire));
+  }
+
+  T* LoadPointer() const {
+    return Load().ptr_;
+  }
+
+  bool Marked() const {
+    return (word_.load(std::memory_order_acquire) & kMarkBit) != 0;
+  }
+
+  void Store(T* ptr, bool marked = false) {
+    word_.store(Pack({ptr, marked}), std::memory_order_release);
+  }
+
+  void Store(MarkedPointer desired) {
+    word_.store(Pack(desired), std::memory_order_release);
+  }
+
+  bool CompareAndSet(MarkedPointer expected, MarkedPointer desired) {
+    uintptr_t expected_word = Pack(expected);
+    return word_.compare_exchange_strong(expected_word, Pack(desired),
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire);
+  }
+
+ private:
+  static const uintptr_t kMarkBit = 1;
+
+  static uintptr_t Pack(MarkedPointer marked_ptr) {
+    static_assert(alignof(T) > 1, "the lowest pointer bit is used for the mark");
+    return reinterpret_cast<uintptr_t>(marked_ptr.ptr_) | (marked_ptr.marked_ ? kMarkBit : 0);
+  }
+
+  static MarkedPointer Unpack(uintptr_t word) {
+    return {reinterpret_cast<T*>(word & ~kMarkBit), (word & kMarkBit) != 0};
+  }
+
+  std::atomic<uintptr_t> word_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Atomic triple (pointer, mark, version) stored in two adjacent words
+// and updated with a double-width CAS (cmpxchg16b on x86-64).
+// Every successful update increments the version, so a MarkedPointer
+// obtained from Load() can not be confused with the same (pointer, mark)
+// pair written again later (ABA).
+// MarkedPointer built by hand (without version) is compared by pointer and mark only.
+template <typename T>
+class VersionedAtomicMarkedPointer {
+ public:
+  static const uint64_t kAnyVersion = UINT64_MAX;
+
+  struct MarkedPointer {
+    T* ptr_;
+    bool marked_;
+    uint64_t version_ = kAnyVersion;
+  };
+
+  VersionedAtomicMarkedPointer(T* ptr = nullptr, bool marked = false) {
+    pair_.word_ = Pack({ptr, marked});
+    pair_.version_ = 0;
+  }
+
+  VersionedAtomicMarkedPointer(const VersionedAtomicMarkedPointer&) = delete;
+  VersionedAtomicMarkedPointer& operator=(const VersionedAtomicMarkedPointer&) = delete;
+
+  MarkedPointer Load() const {
+    Pair pair = LoadPair();
+    MarkedPointer result = Unpack(pair.word_);
+    result.version_ = pair.version_;
+    return result;
+  }
+
+  // The pointer and the mark live in one word, so there is no need to read both halves.
+  T* LoadPointer() const {
+    return Unpack(__atomic_load_n(&pair_.word_, __ATOMIC_ACQUIRE)).ptr_;
+  }
+
+  bool Marked() const {
+    return (__atomic_load_n(&pair_.word_, __ATOMIC_ACQUIRE) & kMarkBit) != 0;
+  }
+
+  void Store(T* ptr, bool marked = false) {
+    Store(MarkedPointer{ptr, marked});
+  }
+
+  void Store(MarkedPointer desired) {
+    Pair current = LoadPair();
+    while (!DoubleWidthCompareAndSet(current, {Pack(desired), current.version_ + 1})) {}
+  }
+
+  bool CompareAndSet(MarkedPointer expected, MarkedPointer desired) {
+    const uintptr_t expected_word = Pack(expected);
+    Pair current = LoadPair();
+    while (true) {
+      if (current.word_ != expected_word) {
+        return false;
+      }
+      if (expected.version_ != kAnyVersion && current.version_ != expected.version_) {
+        return false;
+      }
+      // If the CAS fails, current is refreshed and we check it again:
+      // it may differ from the loaded value in the version only.
+      if (DoubleWidthCompareAndSet(current, {Pack(desired), current.version_ + 1})) {
+        return true;
+      }
+    }
+  }
+
+ private:
+  static const uintptr_t kMarkBit = 1;
+
+  struct alignas(16) Pair {
+    uintptr_t word_;
+    uint64_t version_;
+  };
+
+  static uintptr_t Pack(MarkedPointer marked_ptr) {
+    static_assert(alignof(T) > 1, "the lowest pointer bit is used for the mark");
+    return reinterpret_cast<uintptr_t>(marked_ptr.ptr_) | (marked_ptr.marked_ ? kMarkBit : 0);
+  }
+
+  static MarkedPointer Unpack(uintptr_t word) {
+    return {reinterpret_cast<T*>(word & ~kMarkBit), (word & kMarkBit) != 0};
+  }
+
+  // Every successful CAS changes the version, so if the version has not changed
+  // between two reads, the word read in between belongs to the same pair.
+  Pair LoadPair() const {
+    while (true) {
+      const uint64_t version = __atomic_load_n(&pair_.version_, __ATOMIC_ACQUIRE);
+      const uintptr_t word = __atomic_load_n(&pair_.word_, __ATOMIC_ACQUIRE);
+      if (__atomic_load_n(&pair_.version_, __ATOMIC_ACQUIRE) == version) {
+        return {word, version};
+      }
+    }
+  }
+
+  // On failure writes the current value into expected.
+  bool DoubleWidthCompareAndSet(Pair& expected, Pair desired) {
+#if defined(__x86_64__)
+    bool success;
+    __asm__ __volatile__("lock cmpxchg16b %1\n\t"
+                         "sete %0"
+                         : "=q"(success), "+m"(pair_), "+a"(expected.word_), "+d"(expected.version_)
+                         : "b"(desired.word_), "c"(desired.version_)
+                         : "cc", "memory");
+    return success;
+#else
+    // Without a native instruction the compiler falls back to libatomic.
+    return __atomic_compare_exchange(&pair_, &expected, &desired, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+  }
+
+  Pair pair_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Single-word implementation is the default one:
+// nodes are never reused while the list is alive (they live in the arena),
+// so ABA is impossible and the version counter is not needed.
+template <typename T>
+using AtomicMarkedPointer = TaggedAtomicMarkedPointer<T>;
+
+///////////////////////////////////////////////////////////////////////
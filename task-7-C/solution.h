@@ -10,6 +10,7 @@
 
 #include "atomic_marked_pointer.h"
 #include "arena_allocator.h"
+#include "../common/sharded_counter.h"
 
 #include <atomic>
 #include <limits>
@@ -28,12 +29,16 @@ struct ElementTraits {
 
 ///////////////////////////////////////////////////////////////////////
 
-template <typename Element>
+// MarkedAtomic selects the representation of marked next pointers:
+// TaggedAtomicMarkedPointer (default) or VersionedAtomicMarkedPointer.
+// Counter counts the elements (see common/sharded_counter.h).
+template <typename Element, template <typename U> class MarkedAtomic = AtomicMarkedPointer,
+          class Counter = ShardedCounter>
 class LockFreeLinkedSet {
  private:
   struct Node {
     Element element_;
-    AtomicMarkedPointer<Node> next_;
+    MarkedAtomic<Node> next_;
     
     Node(const Element& element, Node* next = nullptr)
         : element_{element},
@@ -58,16 +63,32 @@ class LockFreeLinkedSet {
   };
   
  public:
+  // A node of the list to start searches from, e.g. a sentinel that is never
+  // removed (see split_ordered_set.h). The operations taking a start
+  // require start->element < element.
+  using Position = Node*;
+  
   explicit LockFreeLinkedSet(ArenaAllocator& allocator)
-      : allocator_(allocator),
-        size_(0) {
+      : allocator_(allocator) {
     CreateEmptyList();
   }
   
   bool Insert(const Element& element) {
+    return Insert(element, head_);
+  }
+  
+  bool Remove(const Element& element) {
+    return Remove(element, head_);
+  }
+  
+  bool Contains(const Element& element) {
+    return Contains(element, head_);
+  }
+  
+  bool Insert(const Element& element, Position start) {
     Node* new_node = allocator_.New<Node>(element);
     while (true) {
-      Edge edge = Locate(element);
+      Edge edge = Locate(element, start);
       if (edge.curr_->element_ == element) {
         return false;
       }
@@ -76,15 +97,15 @@ class LockFreeLinkedSet {
         break;
       }
     }
-    size_.fetch_add(1);
+    size_.Add(1);
     return true;
   }
   
-  bool Remove(const Element& element) {
+  bool Remove(const Element& element, Position start) {
     Edge edge{nullptr, nullptr};
-    typename AtomicMarkedPointer<Node>::MarkedPointer curr_next{nullptr, false};
+    typename MarkedAtomic<Node>::MarkedPointer curr_next{nullptr, false};
     while (true) {
-      edge = Locate(element);
+      edge = Locate(element, start);
       if (edge.curr_->element_ != element) {
         return false;
       }
@@ -97,14 +118,14 @@ class LockFreeLinkedSet {
       }
     }
     if (!edge.pred_->next_.CompareAndSet({edge.curr_, false}, curr_next)) {
-      edge = Locate(edge.curr_->element_);
+      edge = Locate(edge.curr_->element_, start);
     }
-    size_.fetch_sub(1);
+    size_.Add(-1);
     return true;
   }
   
-  bool Contains(const Element& element) {
-    Edge edge = Locate(element);
+  bool Contains(const Element& element, Position start) {
+    Edge edge = Locate(element, start);
     if (edge.curr_->element_ != element) {
       return false;
     } else {
@@ -112,8 +133,33 @@ class LockFreeLinkedSet {
     }
   }
   
+  // Inserts the element unless it is present and returns its node either way.
+  // A node returned for an element that is never removed is a valid start.
+  Position InsertOrFind(const Element& element, Position start) {
+    Node* new_node = nullptr;
+    while (true) {
+      Edge edge = Locate(element, start);
+      if (edge.curr_->element_ == element) {
+        return edge.curr_;
+      }
+      if (new_node == nullptr) {
+        new_node = allocator_.New<Node>(element);
+      }
+      new_node->next_.Store(edge.curr_);
+      if (edge.pred_->next_.CompareAndSet({edge.curr_, false}, {new_node, false})) {
+        size_.Add(1);
+        return new_node;
+      }
+    }
+  }
+  
+  // The node holding ElementTraits<Element>::Min().
+  Position Head() const {
+    return head_;
+  }
+  
   size_t Size() const {
-    return size_.load();
+    return size_.Sum();
   }
   
  private:
@@ -122,13 +168,13 @@ class LockFreeLinkedSet {
     head_->next_.Store(allocator_.New<Node>(ElementTraits<Element>::Max()));
   }
   
-  Edge Locate(const Element& element) {
+  Edge Locate(const Element& element, Node* start) {
     Node* left_node{nullptr};
     Node* left_node_next{nullptr};
     Node* right_node{nullptr};
     
     while (true) {
-      Node* t = head_;
+      Node* t = start;
       
       // Find left node and right node.
       while (t->next_.Marked() || (t->element_ < element)) {
@@ -163,7 +209,7 @@ class LockFreeLinkedSet {
 private:
   ArenaAllocator& allocator_;
   Node* head_;
-  std::atomic<size_t> size_;
+  Counter size_;
 };
 
 ///////////////////////////////////////////////////////////////////////
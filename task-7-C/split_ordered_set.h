@@ -0,0 +1,206 @@
+//
+//  split_ordered_set.h
+//  Lock_free_linked_set
+//
+
+#pragma once
+
+#include "solution.h"
+#include "../common/hash_bits.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+///////////////////////////////////////////////////////////////////////
+
+// Element of the backbone list of SplitOrderedHashSet: the split-order key
+// first, the value to tell apart values with equal hashes.
+template <typename T>
+struct SplitOrderedKey {
+  uint64_t order_;
+  T value_;
+
+  bool operator<(const SplitOrderedKey& other) const {
+    return order_ < other.order_ || (order_ == other.order_ && value_ < other.value_);
+  }
+
+  bool operator==(const SplitOrderedKey& other) const {
+    return order_ == other.order_ && value_ == other.value_;
+  }
+
+  bool operator!=(const SplitOrderedKey& other) const {
+    return !(*this == other);
+  }
+};
+
+template <typename T>
+struct ElementTraits<SplitOrderedKey<T>> {
+  static SplitOrderedKey<T> Min() {
+    return {0, ElementTraits<T>::Min()};
+  }
+  static SplitOrderedKey<T> Max() {
+    return {UINT64_MAX, ElementTraits<T>::Max()};
+  }
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Lock-free hash set of Shalev and Shavit.
+//
+// All elements live in one LockFreeLinkedSet sorted by the bit-reversed hash
+// ("split order"), so the elements of bucket b of a table of 2^k buckets
+// form a contiguous run, and the run splits in two, in place, when the table
+// doubles: bucket b + 2^k takes the second half of it. A bucket is a pointer
+// to a sentinel node that starts its run; sentinels are inserted lazily,
+// on the first access to the bucket, right after the sentinel of the parent
+// bucket (b without its highest bit). Growing the table is a single CAS on
+// the bucket count - no element is ever moved or rehashed.
+//
+// Sentinel keys are reversed bucket indices (lowest bit 0), element keys are
+// reversed hashes with the highest bit set (lowest bit 1), so an element
+// sorts after the sentinel of its bucket and before the next one.
+// The list head (key 0) is the sentinel of bucket 0.
+//
+// The bucket directory is a table of segments of doubling sizes, allocated
+// on first use, so it also grows without copying.
+//
+// Nodes come from the ArenaAllocator, like in LockFreeLinkedSet,
+// and are released with it. The backbone list counts nothing (it would count
+// the sentinels too): the set counts its elements in size_.
+template <typename T, class Hash = std::hash<T>>
+class SplitOrderedHashSet {
+  using List = LockFreeLinkedSet<SplitOrderedKey<T>, AtomicMarkedPointer, NoCounter>;
+  using Bucket = typename List::Position;
+
+ public:
+  explicit SplitOrderedHashSet(ArenaAllocator& allocator, const size_t initial_buckets = 2,
+                               const size_t max_load_factor = 2)
+      : list_(allocator),
+        bucket_count_(std::min(RoundUpToPowerOfTwo(initial_buckets), kMaxBuckets)),
+        max_load_factor_(max_load_factor) {
+    for (std::atomic<std::atomic<Bucket>*>& segment: segments_) {
+      segment.store(nullptr);
+    }
+    BucketSlot(0).store(list_.Head());
+  }
+
+  ~SplitOrderedHashSet() {
+    for (std::atomic<std::atomic<Bucket>*>& segment: segments_) {
+      delete[] segment.load();
+    }
+  }
+
+  SplitOrderedHashSet(const SplitOrderedHashSet&) = delete;
+  SplitOrderedHashSet& operator=(const SplitOrderedHashSet&) = delete;
+
+  bool Insert(const T& element) {
+    const uint64_t hash = HashOf(element);
+    const size_t bucket_count = bucket_count_.load();
+    if (!list_.Insert({RegularKey(hash), element}, GetBucket(hash & (bucket_count - 1)))) {
+      return false;
+    }
+    size_.Add(1);
+    if (size_.Approximate() > bucket_count * max_load_factor_ && bucket_count < kMaxBuckets) {
+      // Losing this race is fine: somebody else has grown the table.
+      size_t expected = bucket_count;
+      bucket_count_.compare_exchange_strong(expected, bucket_count * 2);
+    }
+    return true;
+  }
+
+  bool Remove(const T& element) {
+    const uint64_t hash = HashOf(element);
+    if (!list_.Remove({RegularKey(hash), element}, GetBucket(hash & (bucket_count_.load() - 1)))) {
+      return false;
+    }
+    size_.Add(-1);
+    return true;
+  }
+
+  bool Contains(const T& element) {
+    const uint64_t hash = HashOf(element);
+    return list_.Contains({RegularKey(hash), element}, GetBucket(hash & (bucket_count_.load() - 1)));
+  }
+
+  size_t Size() const {
+    return size_.Sum();
+  }
+
+  size_t BucketCount() const {
+    return bucket_count_.load();
+  }
+
+ private:
+  // Hashes are cut to 62 bits: bit 63 marks element keys, and bit 62
+  // stays zero so that no element key collides with the tail's UINT64_MAX.
+  static const int kHashBits = 62;
+  static const size_t kMaxBuckets = size_t(1) << 32;
+  // Segment 0 holds bucket 0, segment s > 0 holds buckets [2^(s-1), 2^s).
+  static const size_t kSegments = 33;
+
+  // The lowest bits of this pick the bucket.
+  uint64_t HashOf(const T& element) const {
+    return MixBits(static_cast<uint64_t>(hash_(element))) & ((uint64_t(1) << kHashBits) - 1);
+  }
+
+  static uint64_t Reverse(uint64_t value) {
+    value = ((value >> 1) & 0x5555555555555555ULL) | ((value & 0x5555555555555555ULL) << 1);
+    value = ((value >> 2) & 0x3333333333333333ULL) | ((value & 0x3333333333333333ULL) << 2);
+    value = ((value >> 4) & 0x0f0f0f0f0f0f0f0fULL) | ((value & 0x0f0f0f0f0f0f0f0fULL) << 4);
+    return __builtin_bswap64(value);
+  }
+
+  static uint64_t RegularKey(const uint64_t hash) {
+    return Reverse(hash | (uint64_t(1) << 63));
+  }
+
+  static uint64_t SentinelKey(const uint64_t bucket) {
+    return Reverse(bucket);
+  }
+
+  std::atomic<Bucket>& BucketSlot(const size_t bucket) {
+    const size_t segment = bucket == 0 ? 0 : 64 - __builtin_clzll(bucket);
+    const size_t segment_begin = segment == 0 ? 0 : size_t(1) << (segment - 1);
+    std::atomic<Bucket>* buckets = segments_[segment].load();
+    if (buckets == nullptr) {
+      const size_t segment_size = segment == 0 ? 1 : segment_begin;
+      std::atomic<Bucket>* fresh = new std::atomic<Bucket>[segment_size];
+      for (size_t i = 0; i < segment_size; ++i) {
+        fresh[i].store(nullptr);
+      }
+      if (segments_[segment].compare_exchange_strong(buckets, fresh)) {
+        buckets = fresh;
+      } else {
+        delete[] fresh;
+      }
+    }
+    return buckets[bucket - segment_begin];
+  }
+
+  // The sentinel of the bucket, inserted (with those of its ancestors) if missing.
+  Bucket GetBucket(const size_t bucket) {
+    std::atomic<Bucket>& slot = BucketSlot(bucket);
+    Bucket sentinel = slot.load();
+    if (sentinel != nullptr) {
+      return sentinel;
+    }
+    const size_t parent = bucket & ~(size_t(1) << (63 - __builtin_clzll(bucket)));
+    // Concurrent initializers find each other's sentinel, so all of them
+    // store the same node.
+    sentinel = list_.InsertOrFind({SentinelKey(bucket), T{}}, GetBucket(parent));
+    slot.store(sentinel);
+    return sentinel;
+  }
+
+  List list_;
+  Hash hash_;
+  std::atomic<std::atomic<Bucket>*> segments_[kSegments];
+  std::atomic<size_t> bucket_count_;
+  ShardedCounter size_;
+  const size_t max_load_factor_;
+};
+
+///////////////////////////////////////////////////////////////////////
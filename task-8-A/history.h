@@ -0,0 +1,120 @@
+//
+//  history.h
+//  Linearizability
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////
+
+// One completed operation of a concurrent history.
+// method, argument and result are interpreted by the model
+// (see linearizability_checker.h): e.g. for a queue method is Enqueue/Dequeue,
+// argument is the enqueued value, result is the dequeued one and ok tells
+// whether Dequeue found the queue non-empty.
+struct HistoryOperation {
+  uint32_t thread;
+  uint32_t method;
+  int64_t argument;
+  int64_t result;
+  bool ok;
+  uint64_t invoked;
+  uint64_t returned;
+};
+
+using History = std::vector<HistoryOperation>;
+
+// Timestamp that can be compared across threads.
+// On x86 it is the TSC (invariant and synchronized between cores on every
+// CPU we care about) surrounded by fences: mfence drains the store buffer,
+// so the effects of an operation are globally visible before its response
+// time is taken, and the trailing lfence keeps the loads of the next operation
+// after its invocation time.
+inline uint64_t HistoryTimestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_mfence();
+  _mm_lfence();
+  const uint64_t ticks = __rdtsc();
+  _mm_lfence();
+  return ticks;
+#else
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Per-thread history buffers. Every thread appends only to its own buffer,
+// and the buffers are preallocated, so recording costs two timestamps and
+// a few plain stores per operation.
+//
+// usage:
+// HistoryRecorder recorder(num_threads, ops_per_thread);
+// ... in thread i:
+//   HistoryRecorder::Call call = recorder.Invoke(i, kEnqueue, value);
+//   queue.Enqueue(value);
+//   recorder.Respond(call);
+// ... after joining:
+//   History history = recorder.Collect();
+class HistoryRecorder {
+ public:
+  struct Call {
+    uint32_t thread;
+    uint32_t method;
+    int64_t argument;
+    uint64_t invoked;
+  };
+
+  HistoryRecorder(const size_t num_threads, const size_t ops_per_thread)
+      : buffers_(num_threads) {
+    for (ThreadBuffer& buffer: buffers_) {
+      buffer.operations_.reserve(ops_per_thread);
+    }
+  }
+
+  Call Invoke(const size_t thread, const uint32_t method, const int64_t argument = 0) {
+    return {static_cast<uint32_t>(thread), method, argument, HistoryTimestamp()};
+  }
+
+  void Respond(const Call& call, const bool ok = true, const int64_t result = 0) {
+    const uint64_t returned = HistoryTimestamp();
+    buffers_[call.thread].operations_.push_back(
+        {call.thread, call.method, call.argument, result, ok, call.invoked, returned});
+  }
+
+  // Must be called after all recording threads have finished.
+  // Operations are ordered by invocation time.
+  History Collect() const {
+    History history;
+    for (const ThreadBuffer& buffer: buffers_) {
+      history.insert(history.end(), buffer.operations_.begin(), buffer.operations_.end());
+    }
+    std::sort(history.begin(), history.end(), [](const HistoryOperation& lhs, const HistoryOperation& rhs) {
+      return lhs.invoked < rhs.invoked;
+    });
+    return history;
+  }
+
+ private:
+  // Own cache lines, so that threads don't write next to each other.
+  struct alignas(64) ThreadBuffer {
+    std::vector<HistoryOperation> operations_;
+  };
+
+  std::vector<ThreadBuffer> buffers_;
+};
+
+///////////////////////////////////////////////////////////////////////
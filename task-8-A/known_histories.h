@@ -0,0 +1,138 @@
+//
+//  known_histories.h
+//  Linearizability
+//
+//  Small hand-written histories with a known answer. The history checkers
+//  run them before checking anything recorded, and check-known-histories
+//  runs them under CTest, so a regression in the checker shows up as
+//  a wrong verdict here.
+//
+
+#pragma once
+
+#include "history.h"
+#include "linearizability_checker.h"
+
+#include <string>
+#include <vector>
+
+struct KnownHistory {
+  std::string name;
+  History history;
+  bool linearizable;
+};
+
+// Operation of thread `thread` over the interval [invoked, returned].
+inline HistoryOperation Op(const uint32_t thread, const uint32_t method, const int64_t argument,
+                           const bool ok, const int64_t result,
+                           const uint64_t invoked, const uint64_t returned) {
+  return {thread, method, argument, result, ok, invoked, returned};
+}
+
+inline std::vector<KnownHistory> KnownSetHistories() {
+  return {
+      {"contains a key that was never inserted",
+       {Op(0, SetModel::kContains, 1, true, 0, 0, 1)},
+       false},
+      {"second successful insert without a remove",
+       {Op(0, SetModel::kInsert, 1, true, 0, 0, 1),
+        Op(1, SetModel::kInsert, 1, true, 0, 2, 3)},
+       false},
+      {"two concurrent removes of one inserted key both succeed",
+       {Op(0, SetModel::kInsert, 1, true, 0, 0, 1),
+        Op(0, SetModel::kRemove, 1, true, 0, 2, 5),
+        Op(1, SetModel::kRemove, 1, true, 0, 3, 4)},
+       false},
+      {"lookup misses a key whose insert has completed",
+       {Op(0, SetModel::kInsert, 7, true, 0, 0, 1),
+        Op(1, SetModel::kContains, 7, false, 0, 2, 3)},
+       false},
+      {"lookup concurrent with insert may miss the key",
+       {Op(0, SetModel::kInsert, 7, true, 0, 0, 3),
+        Op(1, SetModel::kContains, 7, false, 0, 1, 2),
+        Op(1, SetModel::kContains, 7, true, 0, 4, 5)},
+       true},
+      {"operations on different keys don't interfere",
+       {Op(0, SetModel::kInsert, 1, true, 0, 0, 4),
+        Op(1, SetModel::kInsert, 2, true, 0, 1, 2),
+        Op(1, SetModel::kRemove, 1, true, 0, 5, 6),
+        Op(0, SetModel::kContains, 2, true, 0, 5, 7)},
+       true},
+  };
+}
+
+inline std::vector<KnownHistory> KnownQueueHistories() {
+  return {
+      {"dequeue order differs from enqueue order",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 1),
+        Op(0, QueueModel::kEnqueue, 2, true, 0, 2, 3),
+        Op(1, QueueModel::kDequeue, 0, true, 2, 4, 5),
+        Op(1, QueueModel::kDequeue, 0, true, 1, 6, 7)},
+       false},
+      {"dequeue of a value that was never enqueued",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 1),
+        Op(1, QueueModel::kDequeue, 0, true, 5, 2, 3)},
+       false},
+      {"dequeue reports an empty queue that holds an element",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 1),
+        Op(1, QueueModel::kDequeue, 0, false, 0, 2, 3),
+        Op(1, QueueModel::kDequeue, 0, true, 1, 4, 5)},
+       false},
+      {"one element dequeued twice by concurrent dequeues",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 1),
+        Op(1, QueueModel::kDequeue, 0, true, 1, 2, 5),
+        Op(2, QueueModel::kDequeue, 0, true, 1, 3, 4)},
+       false},
+      // Both enqueues are concurrent, so either order is fine.
+      {"concurrent enqueues dequeued in the reverse order",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 3),
+        Op(1, QueueModel::kEnqueue, 2, true, 0, 1, 2),
+        Op(2, QueueModel::kDequeue, 0, true, 2, 4, 5),
+        Op(2, QueueModel::kDequeue, 0, true, 1, 6, 7)},
+       true},
+      // A dequeue that overlaps an enqueue may see the queue empty or not.
+      {"dequeue concurrent with the only enqueue sees an empty queue",
+       {Op(0, QueueModel::kEnqueue, 1, true, 0, 0, 3),
+        Op(1, QueueModel::kDequeue, 0, false, 0, 1, 2),
+        Op(1, QueueModel::kDequeue, 0, true, 1, 4, 5)},
+       true},
+  };
+}
+
+inline std::vector<KnownHistory> KnownStackHistories() {
+  return {
+      {"pops in push order",
+       {Op(0, StackModel::kPush, 1, true, 0, 0, 1),
+        Op(0, StackModel::kPush, 2, true, 0, 2, 3),
+        Op(1, StackModel::kPop, 0, true, 1, 4, 5),
+        Op(1, StackModel::kPop, 0, true, 2, 6, 7)},
+       false},
+      {"pop reports an empty stack that holds an element",
+       {Op(0, StackModel::kPush, 1, true, 0, 0, 1),
+        Op(1, StackModel::kPop, 0, false, 0, 2, 3)},
+       false},
+      {"one element popped twice",
+       {Op(0, StackModel::kPush, 1, true, 0, 0, 1),
+        Op(1, StackModel::kPop, 0, true, 1, 2, 3),
+        Op(2, StackModel::kPop, 0, true, 1, 4, 5)},
+       false},
+      {"concurrent pushes popped in either order",
+       {Op(0, StackModel::kPush, 1, true, 0, 0, 3),
+        Op(1, StackModel::kPush, 2, true, 0, 1, 2),
+        Op(2, StackModel::kPop, 0, true, 1, 4, 5),
+        Op(2, StackModel::kPop, 0, true, 2, 6, 7)},
+       true},
+  };
+}
+
+// Checks every known history and returns the names of the ones with a wrong verdict.
+template <class Check>
+std::vector<std::string> WrongVerdicts(const std::vector<KnownHistory>& histories, Check check) {
+  std::vector<std::string> wrong;
+  for (const KnownHistory& known: histories) {
+    if (check(known.history) != known.linearizable) {
+      wrong.push_back(known.name);
+    }
+  }
+  return wrong;
+}
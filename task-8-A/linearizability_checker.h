@@ -0,0 +1,417 @@
+//
+//  linearizability_checker.h
+//  Linearizability
+//
+
+#pragma once
+
+#include "history.h"
+#include "../common/hash_bits.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////
+
+// Hash of a value stored at the given position of a sequence.
+// Sequential specifications keep the sum of these over their contents,
+// which is updated in O(1) on every push and pop.
+inline uint64_t PositionalHash(const int64_t value, const int64_t position) {
+  return MixBits(MixBits(static_cast<uint64_t>(value)) ^ static_cast<uint64_t>(position));
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Sequential specifications. Apply() returns false, and leaves the state
+// unchanged, if the recorded result of the operation is impossible in the
+// current state; Undo() reverts the last successful Apply() of the same operation.
+// Hash() identifies the state for memoization.
+
+// Set restricted to a single key (histories of sets are checked key by key).
+class SetModel {
+ public:
+  enum Method : uint32_t {
+    kInsert,
+    kRemove,
+    kContains
+  };
+
+  bool Apply(const HistoryOperation& operation) {
+    switch (operation.method) {
+      case kInsert:
+        if (operation.ok == present_) {
+          return false;
+        }
+        present_ = true;
+        return true;
+      case kRemove:
+        if (operation.ok != present_) {
+          return false;
+        }
+        present_ = false;
+        return true;
+      default:
+        return operation.ok == present_;
+    }
+  }
+
+  void Undo(const HistoryOperation& operation) {
+    if (operation.ok && operation.method == kInsert) {
+      present_ = false;
+    } else if (operation.ok && operation.method == kRemove) {
+      present_ = true;
+    }
+  }
+
+  uint64_t Hash() const {
+    return present_ ? 1 : 0;
+  }
+
+ private:
+  bool present_{false};
+};
+
+// FIFO queue; Dequeue with ok == false means the queue was empty.
+class QueueModel {
+ public:
+  enum Method : uint32_t {
+    kEnqueue,
+    kDequeue
+  };
+
+  bool Apply(const HistoryOperation& operation) {
+    if (operation.method == kEnqueue) {
+      hash_ += PositionalHash(operation.argument, head_ + values_.size());
+      values_.push_back(operation.argument);
+      return true;
+    }
+    if (!operation.ok) {
+      return values_.empty();
+    }
+    if (values_.empty() || values_.front() != operation.result) {
+      return false;
+    }
+    hash_ -= PositionalHash(values_.front(), head_);
+    values_.pop_front();
+    ++head_;
+    return true;
+  }
+
+  void Undo(const HistoryOperation& operation) {
+    if (operation.method == kEnqueue) {
+      values_.pop_back();
+      hash_ -= PositionalHash(operation.argument, head_ + values_.size());
+    } else if (operation.ok) {
+      --head_;
+      values_.push_front(operation.result);
+      hash_ += PositionalHash(operation.result, head_);
+    }
+  }
+
+  uint64_t Hash() const {
+    return hash_;
+  }
+
+ private:
+  std::deque<int64_t> values_;
+  // Absolute position of the front element.
+  int64_t head_{0};
+  uint64_t hash_{0};
+};
+
+// LIFO stack; Pop with ok == false means the stack was empty.
+//
+// Built from a history with unique values, the model also refuses pushes
+// that no continuation can pop in time: x can't go on top of y if y's pop
+// returned before x's pop was invoked, or if x is never popped while y is.
+// The search would find that out anyway, but only after linearizing
+// everything up to y's pop - thousands of steps if x's push was preempted.
+class StackModel {
+ public:
+  enum Method : uint32_t {
+    kPush,
+    kPop
+  };
+
+  StackModel() = default;
+
+  explicit StackModel(const History& history) {
+    for (const HistoryOperation& operation: history) {
+      if (operation.method == kPop && operation.ok) {
+        pops_[operation.result] = {operation.invoked, operation.returned};
+      }
+    }
+  }
+
+  bool Apply(const HistoryOperation& operation) {
+    if (operation.method == kPush) {
+      if (!values_.empty() && !CanGoAbove(operation.argument, values_.back())) {
+        return false;
+      }
+      hash_ += PositionalHash(operation.argument, values_.size());
+      values_.push_back(operation.argument);
+      return true;
+    }
+    if (!operation.ok) {
+      return values_.empty();
+    }
+    if (values_.empty() || values_.back() != operation.result) {
+      return false;
+    }
+    values_.pop_back();
+    hash_ -= PositionalHash(operation.result, values_.size());
+    return true;
+  }
+
+  void Undo(const HistoryOperation& operation) {
+    if (operation.method == kPush) {
+      values_.pop_back();
+      hash_ -= PositionalHash(operation.argument, values_.size());
+    } else if (operation.ok) {
+      hash_ += PositionalHash(operation.result, values_.size());
+      values_.push_back(operation.result);
+    }
+  }
+
+  uint64_t Hash() const {
+    return hash_;
+  }
+
+ private:
+  struct Interval {
+    uint64_t invoked;
+    uint64_t returned;
+  };
+
+  bool CanGoAbove(const int64_t value, const int64_t below) const {
+    if (pops_.empty()) {
+      return true;
+    }
+    auto below_pop = pops_.find(below);
+    if (below_pop == pops_.end()) {
+      return true;
+    }
+    auto pop = pops_.find(value);
+    return pop != pops_.end() && below_pop->second.returned >= pop->second.invoked;
+  }
+
+  std::vector<int64_t> values_;
+  uint64_t hash_{0};
+  std::unordered_map<int64_t, Interval> pops_;
+};
+
+///////////////////////////////////////////////////////////////////////
+
+// Wing-Gong search with Lowe's improvements.
+//
+// Call and return events of all operations form a doubly-linked list ordered
+// by time. The candidates to be linearized next are the operations whose calls
+// precede the first return event in the list. The search linearizes one of them
+// (applies it to the model and unlinks both of its events) and repeats;
+// if none fits, it backtracks and tries the next candidate of the previous step.
+// The history is linearizable if the list becomes empty.
+//
+// Memoization (Lowe): a pair (set of linearized operations, model state) that
+// has been reached once is never explored again. Both halves are kept as 64-bit
+// hashes - Zobrist hashing for the set, Model::Hash() for the state - so
+// a step costs O(1) regardless of the history length; a false match would need
+// a collision of 128 bits.
+//
+// Candidates are tried in the order of priorities[operation] (lower first,
+// call order among equal ones). Any order gives the same answer, but a good
+// guess avoids exploring wrong placements of long operations, e.g. of one
+// that was preempted in the middle while other threads ran thousands of operations.
+//
+// Operations whose intervals touch are considered concurrent.
+template <class Model>
+bool IsLinearizable(const History& history, const std::vector<int64_t>& priorities = {},
+                    Model model = Model()) {
+  const size_t num_operations = history.size();
+  if (num_operations == 0) {
+    return true;
+  }
+
+  // Events 2i and 2i + 1 are the call and the return of operation i;
+  // index 2n is the head of the list.
+  const size_t num_events = 2 * num_operations;
+  const size_t head = num_events;
+  const size_t nil = num_events + 1;
+  std::vector<size_t> order(num_events);
+  for (size_t i = 0; i < num_events; ++i) {
+    order[i] = i;
+  }
+  auto time = [&history](const size_t event) {
+    const HistoryOperation& operation = history[event / 2];
+    return event % 2 == 0 ? operation.invoked : operation.returned;
+  };
+  std::sort(order.begin(), order.end(), [&time](const size_t lhs, const size_t rhs) {
+    const uint64_t lhs_time = time(lhs);
+    const uint64_t rhs_time = time(rhs);
+    if (lhs_time != rhs_time) {
+      return lhs_time < rhs_time;
+    }
+    // Calls go first, so that touching intervals overlap.
+    return lhs % 2 < rhs % 2;
+  });
+  std::vector<size_t> next(num_events + 1);
+  std::vector<size_t> prev(num_events + 1);
+  size_t last = head;
+  for (const size_t event: order) {
+    next[last] = event;
+    prev[event] = last;
+    last = event;
+  }
+  next[last] = nil;
+
+  auto unlink = [&next, &prev, nil](const size_t event) {
+    next[prev[event]] = next[event];
+    if (next[event] != nil) {
+      prev[next[event]] = prev[event];
+    }
+  };
+  // Dancing links: an unlinked event keeps its neighbours, so unlinking
+  // in reverse order puts it back.
+  auto relink = [&next, &prev, nil](const size_t event) {
+    next[prev[event]] = event;
+    if (next[event] != nil) {
+      prev[next[event]] = event;
+    }
+  };
+  auto priority = [&priorities](const size_t operation) {
+    return priorities.empty() ? 0 : priorities[operation];
+  };
+
+  struct PairHash {
+    size_t operator()(const std::pair<uint64_t, uint64_t>& key) const {
+      return MixBits(key.first ^ MixBits(key.second));
+    }
+  };
+  std::unordered_set<std::pair<uint64_t, uint64_t>, PairHash> visited;
+  uint64_t linearized_hash = 0;
+
+  // Candidates of every step of the current path are kept in one vector:
+  // the step owns candidates[begin_, <begin_ of the next step>).
+  struct Step {
+    size_t begin_;
+    size_t next_candidate_;
+    size_t operation_;
+  };
+  std::vector<Step> path;
+  std::vector<size_t> candidates;
+
+  while (next[head] != nil) {
+    size_t begin = candidates.size();
+    for (size_t event = next[head]; event != nil && event % 2 == 0; event = next[event]) {
+      candidates.push_back(event / 2);
+    }
+    std::stable_sort(candidates.begin() + begin, candidates.end(), [&priority](const size_t lhs, const size_t rhs) {
+      return priority(lhs) < priority(rhs);
+    });
+    size_t index = begin;
+    while (true) {
+      bool linearized = false;
+      for (; index < candidates.size(); ++index) {
+        const size_t operation = candidates[index];
+        if (!model.Apply(history[operation])) {
+          continue;
+        }
+        const uint64_t hash = linearized_hash ^ MixBits(operation);
+        if (visited.insert({hash, model.Hash()}).second) {
+          linearized_hash = hash;
+          path.push_back({begin, index + 1, operation});
+          unlink(2 * operation + 1);
+          unlink(2 * operation);
+          linearized = true;
+          break;
+        }
+        model.Undo(history[operation]);
+      }
+      if (linearized) {
+        break;
+      }
+      // Dead end: go back to the previous step and try its next candidate.
+      candidates.resize(begin);
+      if (path.empty()) {
+        return false;
+      }
+      const Step step = path.back();
+      path.pop_back();
+      model.Undo(history[step.operation_]);
+      linearized_hash ^= MixBits(step.operation_);
+      relink(2 * step.operation_);
+      relink(2 * step.operation_ + 1);
+      begin = step.begin_;
+      index = step.next_candidate_;
+    }
+  }
+  return true;
+}
+
+// Search orders for queues and stacks with unique values.
+// Removals go first: the one that fits the current state either applies
+// right away or is rejected at once. Insertions are ordered by the time
+// their values were removed: FIFO order for a queue, the reverse for a stack
+// (an element removed later has been pushed deeper). Insertions of values
+// that were never removed go last in a queue and first (deepest) in a stack.
+inline std::vector<int64_t> RemovalOrderPriorities(const History& history, const uint32_t insert_method,
+                                                   const bool last_in_first_out) {
+  std::unordered_map<int64_t, int64_t> removed_at;
+  for (const HistoryOperation& operation: history) {
+    if (operation.method != insert_method && operation.ok) {
+      removed_at[operation.result] = static_cast<int64_t>(operation.invoked);
+    }
+  }
+  std::vector<int64_t> priorities(history.size(), INT64_MIN);
+  for (size_t i = 0; i < history.size(); ++i) {
+    if (history[i].method != insert_method) {
+      continue;
+    }
+    auto removal = removed_at.find(history[i].argument);
+    if (removal == removed_at.end()) {
+      priorities[i] = last_in_first_out ? INT64_MIN + 1 : INT64_MAX;
+    } else {
+      priorities[i] = last_in_first_out ? -removal->second : removal->second;
+    }
+  }
+  return priorities;
+}
+
+///////////////////////////////////////////////////////////////////////
+
+// Sets are P-compositional: a set history is linearizable iff, for every key,
+// the subhistory of operations on that key is linearizable w.r.t. a set
+// holding only that key. The subhistories are short and much less concurrent,
+// so the search over them is close to linear.
+inline bool IsLinearizableSetHistory(const History& history) {
+  std::map<int64_t, History> by_key;
+  for (const HistoryOperation& operation: history) {
+    by_key[operation.argument].push_back(operation);
+  }
+  for (const auto& key_history: by_key) {
+    if (!IsLinearizable<SetModel>(key_history.second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Queues and stacks are not P-compositional, so the whole history is searched
+// at once; values are expected to be unique.
+inline bool IsLinearizableQueueHistory(const History& history) {
+  return IsLinearizable<QueueModel>(history, RemovalOrderPriorities(history, QueueModel::kEnqueue, false));
+}
+
+inline bool IsLinearizableStackHistory(const History& history) {
+  return IsLinearizable<StackModel>(history, RemovalOrderPriorities(history, StackModel::kPush, true),
+                                    StackModel(history));
+}
+
+///////////////////////////////////////////////////////////////////////